@@ -0,0 +1,122 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <chrono>
+#include <vector>
+
+#include "JobSystem.h"
+#include "PixelConvert.h"
+
+#define BENCH_WIDTH 4096
+#define BENCH_HEIGHT 4096
+#define BENCH_RUNS 10
+
+struct Conversion
+{
+    const char *name;
+    uint32_t flags;
+};
+
+static const Conversion conversions[] = {
+    { "copy", 0 },
+    { "flip", PixelConvertFlipY },
+    { "swizzle", PixelConvertSwizzleRB },
+    { "premultiply", PixelConvertPremultiply },
+    { "premultiply srgb", PixelConvertPremultiplySRGB },
+    { "flip + premultiply srgb + swizzle", PixelConvertFlipY | PixelConvertPremultiplySRGB | PixelConvertSwizzleRB }
+};
+
+static const char *pathNames[] = { "best", "scalar", "sse2", "avx2" };
+
+// Best of several runs, in milliseconds
+static double TimeConversion(uint8_t *dst, const uint8_t *src, uint32_t flags, PixelConvertPath path)
+{
+    double best = 1e30;
+
+    for (uint32_t run = 0; run < BENCH_RUNS; ++run)
+    {
+        auto start = std::chrono::high_resolution_clock::now();
+        ConvertPixels(dst, src, BENCH_WIDTH, BENCH_HEIGHT, 4, flags, path);
+        auto end = std::chrono::high_resolution_clock::now();
+
+        double ms = std::chrono::duration<double, std::milli>(end - start).count();
+        if (ms < best)
+            best = ms;
+    }
+
+    return best;
+}
+
+static void RunConversions(const uint8_t *src, uint8_t *reference, uint8_t *dst, bool *failed)
+{
+    for (const Conversion &conversion : conversions)
+    {
+        double scalar = TimeConversion(reference, src, conversion.flags, PixelConvertPathScalar);
+        printf("  %-34s scalar %8.2f ms", conversion.name, scalar);
+
+        for (PixelConvertPath path : { PixelConvertPathSSE2, PixelConvertPathAVX2 })
+        {
+            if (!IsPixelConvertPathSupported(path))
+                continue;
+
+            memset(dst, 0, BENCH_WIDTH * BENCH_HEIGHT * 4);
+            double ms = TimeConversion(dst, src, conversion.flags, path);
+
+            bool matches = memcmp(dst, reference, BENCH_WIDTH * BENCH_HEIGHT * 4) == 0;
+            if (!matches)
+                *failed = true;
+
+            printf("  %s %8.2f ms (%.2fx)%s", pathNames[path], ms, scalar / ms, matches ? "" : " MISMATCH");
+        }
+
+        printf("\n");
+    }
+}
+
+int main()
+{
+    std::vector<uint8_t> src(BENCH_WIDTH * BENCH_HEIGHT * 4);
+    std::vector<uint8_t> reference(src.size());
+    std::vector<uint8_t> dst(src.size());
+
+    // Random colors with alpha in runs of fully opaque, fully transparent and partial coverage, like a sprite sheet
+    srand(1);
+    for (size_t i = 0; i < src.size(); i += 4)
+    {
+        src[i + 0] = (uint8_t)(rand() & 0xFF);
+        src[i + 1] = (uint8_t)(rand() & 0xFF);
+        src[i + 2] = (uint8_t)(rand() & 0xFF);
+
+        uint32_t run = (uint32_t)(i / 4 / 64);
+        switch ((run * 2654435761u >> 16) % 4)
+        {
+            case 0:
+            case 1: src[i + 3] = 255; break;
+            case 2: src[i + 3] = 0; break;
+            default: src[i + 3] = (uint8_t)(rand() & 0xFF); break;
+        }
+    }
+
+    bool failed = false;
+
+    printf("%dx%d RGBA8, best of %d runs\n", BENCH_WIDTH, BENCH_HEIGHT, BENCH_RUNS);
+
+    printf("single thread:\n");
+    RunConversions(src.data(), reference.data(), dst.data(), &failed);
+
+    InitJobSystem();
+
+    printf("%u workers + caller:\n", GetJobWorkerCount());
+    RunConversions(src.data(), reference.data(), dst.data(), &failed);
+
+    ShutdownJobSystem();
+
+    if (failed)
+    {
+        printf("SIMD output does not match the scalar path\n");
+        return 1;
+    }
+
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,183 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+#include <chrono>
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/packing.hpp>
+
+#include "SpriteBatch.h"
+
+#define BENCH_BATCHES 64
+#define BENCH_RUNS 20
+
+struct Sprite
+{
+    glm::vec2 position;
+    glm::vec2 size;
+    float rotation;
+    glm::vec2 origin;
+    glm::vec4 texCoord;
+    glm::vec4 color;
+};
+
+static const char *pathNames[] = { "best", "scalar", "sse2", "avx2" };
+
+// What a straightforward renderer does per sprite: build a model matrix and transform each corner
+static void ExpandSpritesGlm(const Sprite *sprites, uint32_t count, BatchVertex *dst)
+{
+    static const glm::vec2 corners[4] = { { 0.0f, 0.0f }, { 1.0f, 0.0f }, { 1.0f, 1.0f }, { 0.0f, 1.0f } };
+
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        const Sprite &sprite = sprites[i];
+
+        glm::mat4 model = glm::translate(glm::mat4(1.0f), glm::vec3(sprite.position, 0.0f));
+        model = glm::rotate(model, sprite.rotation, glm::vec3(0.0f, 0.0f, 1.0f));
+        model = glm::translate(model, glm::vec3(-sprite.origin, 0.0f));
+        model = glm::scale(model, glm::vec3(sprite.size, 1.0f));
+
+        uint32_t color = glm::packUnorm4x8(sprite.color);
+
+        for (uint32_t k = 0; k < SPRITE_VERTEX_COUNT; ++k)
+        {
+            glm::vec2 corner = corners[k];
+            glm::vec4 pos = model * glm::vec4(corner, 0.0f, 1.0f);
+
+            glm::vec2 uv = { sprite.texCoord.x + corner.x * sprite.texCoord.z, sprite.texCoord.y + (1.0f - corner.y) * sprite.texCoord.w };
+
+            dst[i * SPRITE_VERTEX_COUNT + k] = { pos.x, pos.y, glm::packUnorm2x16(uv), color };
+        }
+    }
+}
+
+// Same packing as RenderSpriteEx, the sine and cosine are taken once per sprite when it is queued
+static void FillStream(SpriteStream *stream, const Sprite *sprites, uint32_t count)
+{
+    stream->count = count;
+
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        const Sprite &sprite = sprites[i];
+
+        stream->x[i] = sprite.position.x;
+        stream->y[i] = sprite.position.y;
+        stream->cosine[i] = cosf(sprite.rotation);
+        stream->sine[i] = sinf(sprite.rotation);
+
+        stream->left[i] = -sprite.origin.x;
+        stream->top[i] = -sprite.origin.y;
+        stream->right[i] = sprite.size.x - sprite.origin.x;
+        stream->bottom[i] = sprite.size.y - sprite.origin.y;
+
+        stream->texStart[i] = glm::packUnorm2x16({ sprite.texCoord.x, sprite.texCoord.y });
+        stream->texEnd[i] = glm::packUnorm2x16({ sprite.texCoord.x + sprite.texCoord.z, sprite.texCoord.y + sprite.texCoord.w });
+        stream->color[i] = glm::packUnorm4x8(sprite.color);
+    }
+}
+
+// Positions may differ in the last bits depending on FMA contraction, uvs by one unit of rounding
+static bool VerticesMatch(const BatchVertex *a, const BatchVertex *b, size_t count)
+{
+    for (size_t i = 0; i < count; ++i)
+    {
+        float tolerance = 1e-3f * (1.0f + fabsf(a[i].x) + fabsf(a[i].y));
+        if (fabsf(a[i].x - b[i].x) > tolerance || fabsf(a[i].y - b[i].y) > tolerance || a[i].color != b[i].color)
+            return false;
+
+        int du = (int)(a[i].uv & 0xFFFF) - (int)(b[i].uv & 0xFFFF);
+        int dv = (int)(a[i].uv >> 16) - (int)(b[i].uv >> 16);
+        if (abs(du) > 1 || abs(dv) > 1)
+            return false;
+    }
+
+    return true;
+}
+
+template <typename F>
+static double TimeBest(F func)
+{
+    double best = 1e30;
+
+    for (uint32_t run = 0; run < BENCH_RUNS; ++run)
+    {
+        auto start = std::chrono::high_resolution_clock::now();
+        func();
+        auto end = std::chrono::high_resolution_clock::now();
+
+        double ms = std::chrono::duration<double, std::milli>(end - start).count();
+        if (ms < best)
+            best = ms;
+    }
+
+    return best;
+}
+
+int main()
+{
+    const uint32_t spriteCount = BENCH_BATCHES * SPRITE_BATCH_SIZE;
+
+    std::vector<Sprite> sprites(spriteCount);
+
+    srand(1);
+    for (Sprite &sprite : sprites)
+    {
+        sprite.position = { (float)(rand() % 1920), (float)(rand() % 1080) };
+        sprite.size = { (float)(8 + rand() % 120), (float)(8 + rand() % 120) };
+        sprite.rotation = (rand() % 4 == 0) ? 0.0f : (float)(rand() % 6283) / 1000.0f;
+        sprite.origin = sprite.size * 0.5f;
+
+        float u = (float)(rand() % 16) / 16.0f;
+        float v = (float)(rand() % 16) / 16.0f;
+        sprite.texCoord = { u, v, 1.0f / 16.0f, 1.0f / 16.0f };
+        sprite.color = { (rand() % 256) / 255.0f, (rand() % 256) / 255.0f, (rand() % 256) / 255.0f, 1.0f };
+    }
+
+    std::vector<SpriteStream> streams(BENCH_BATCHES);
+    for (uint32_t b = 0; b < BENCH_BATCHES; ++b)
+    {
+        FillStream(&streams[b], sprites.data() + b * SPRITE_BATCH_SIZE, SPRITE_BATCH_SIZE);
+    }
+
+    size_t vertexCount = (size_t)spriteCount * SPRITE_VERTEX_COUNT;
+    std::vector<BatchVertex> reference(vertexCount);
+    std::vector<BatchVertex> dst(vertexCount);
+
+    bool failed = false;
+
+    printf("%u sprites, %u per batch, best of %d runs\n", spriteCount, SPRITE_BATCH_SIZE, BENCH_RUNS);
+
+    double glmMs = TimeBest([&]() { ExpandSpritesGlm(sprites.data(), spriteCount, reference.data()); });
+    printf("  %-8s %8.3f ms  %6.2f ns/sprite\n", "glm", glmMs, glmMs * 1e6 / spriteCount);
+
+    for (SpriteKernelPath path : { SpriteKernelPathScalar, SpriteKernelPathSSE2, SpriteKernelPathAVX2 })
+    {
+        if (!IsSpriteKernelPathSupported(path))
+            continue;
+
+        double ms = TimeBest([&]()
+        {
+            for (uint32_t b = 0; b < BENCH_BATCHES; ++b)
+            {
+                ExpandSprites(&streams[b], dst.data() + (size_t)b * SPRITE_BATCH_SIZE * SPRITE_VERTEX_COUNT, path);
+            }
+        });
+
+        bool matches = VerticesMatch(reference.data(), dst.data(), vertexCount);
+        if (!matches)
+            failed = true;
+
+        printf("  %-8s %8.3f ms  %6.2f ns/sprite (%.2fx)%s\n", pathNames[path], ms, ms * 1e6 / spriteCount, glmMs / ms, matches ? "" : " MISMATCH");
+    }
+
+    if (failed)
+    {
+        printf("Kernel output does not match the glm path\n");
+        return 1;
+    }
+
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,162 @@
+#include <stdio.h>
+
+#include <vector>
+
+#include "Renderer.h"
+#include "Internal.h"
+#include "Font.h"
+
+// Regression test for the sprite batch texture outliving a texture pool reallocation. Text drawn after
+// a sprite creates its first atlas page while the sprite is still queued, and that page is allocated
+// with the pool full so the pool has to grow. The queued batch must still resolve to the sprite.
+
+// Reported to ctest as skipped, for runs without a font or a GPU
+#define TEST_SKIPPED 77
+
+static std::vector<Texture *> fillers;
+
+// Uses up free slots and spare capacity, so the next AllocateTexture moves TexturePool::textures
+static void FillTexturePool()
+{
+    TexturePool &pool = renderer.texturePool;
+
+    uint8_t pixel[4] = { 255, 255, 255, 255 };
+    while (!pool.freeList.empty() || pool.textures.size() < pool.textures.capacity())
+    {
+        fillers.push_back(LoadTextureFromPixels(1, 1, pixel));
+    }
+}
+
+static void QueueSprite(Texture *sprite, float y)
+{
+    RenderSpriteEx(sprite, { 10.0f, y }, { 16.0f, 16.0f }, 0.0f, glm::vec2(0.0f), glm::vec4(0.0f, 0.0f, 1.0f, 1.0f), glm::vec4(1.0f));
+}
+
+// Checks the state the next flush draws from: the queued sprite and the descriptor set of its texture
+static bool CheckQueuedSprite(const char *step, Texture *sprite, VkDescriptorSet spriteSet)
+{
+    bool passed = true;
+
+    if (renderer.spriteBatch.count != 1)
+    {
+        printf("%s: the queued sprite was flushed before the check, the test is not exercising anything\n", step);
+        passed = false;
+    }
+
+    if (renderer.batchTexture != sprite || !IsTextureValid(renderer.batchTexture))
+    {
+        printf("%s: the sprite batch lost its texture\n", step);
+        return false;
+    }
+
+    _Texture *texture = GetTexture(renderer.batchTexture);
+    if (texture->width != 4 || texture->height != 4 || GetTextureHot(texture).set != spriteSet)
+    {
+        printf("%s: the sprite batch resolves to another texture\n", step);
+        passed = false;
+    }
+
+    return passed;
+}
+
+// The text's first quad flushed the sprite, so the batch only holds glyphs of the new page
+static bool CheckSpriteFlushed(const char *step, Texture *sprite)
+{
+    if (renderer.batchTexture != sprite && renderer.spriteBatch.count > 0)
+        return true;
+
+    printf("%s: the queued sprite was not flushed by the text\n", step);
+    return false;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 2 || !argv[1][0])
+    {
+        printf("Skipped, no font given. Usage: vk2d-test-batch-texture <font.ttf>\n");
+        return TEST_SKIPPED;
+    }
+
+    Window *window = OpenWindow(320, 240, "Batch texture test");
+
+    RendererResult res = RendererInit();
+    if (res != ResultSuccess)
+    {
+        printf("Skipped, failed to initialize renderer: %d\n", res);
+        return TEST_SKIPPED;
+    }
+
+    Font *handle = LoadFontFromFile(argv[1]);
+    if (!handle)
+        return 1;
+
+    _Font *font = (_Font *)handle;
+
+    uint8_t pixels[4 * 4 * 4] = {};
+    Texture *sprite = LoadTextureFromPixels(4, 4, pixels);
+
+    bool passed = true;
+
+    RendererBeginFrame();
+
+    // Bitmap text. RenderText rasterizes every glyph before it queues any, so the same calls made here
+    // add the first glyph page with the sprite still queued
+    QueueSprite(sprite, 10.0f);
+    VkDescriptorSet spriteSet = GetTextureHot(GetTexture(sprite)).set;
+
+    FillTexturePool();
+    const _Texture *before = renderer.texturePool.textures.data();
+
+    uint32_t pixelSize = GetFontPixelSize(24.0f);
+    for (const PlacedGlyph &placed : GetTextLayout(font, "Batch", pixelSize).glyphs)
+    {
+        GetGlyphCell(font, placed.glyph, pixelSize);
+    }
+
+    if (renderer.texturePool.textures.data() == before)
+    {
+        printf("The glyph page did not reallocate the texture pool, the test is not exercising anything\n");
+        passed = false;
+    }
+
+    passed = CheckQueuedSprite("RenderText", sprite, spriteSet) && passed;
+
+    RenderText(handle, "Batch", { 10.0f, 40.0f }, 24.0f);
+    passed = CheckSpriteFlushed("RenderText", sprite) && passed;
+
+    // Distance field text, PrepareMsdfGlyphs adds the first distance field page the same way
+    QueueSprite(sprite, 80.0f);
+    spriteSet = GetTextureHot(GetTexture(sprite)).set;
+
+    FillTexturePool();
+    before = renderer.texturePool.textures.data();
+
+    PrepareMsdfGlyphs(font, GetTextLayout(font, "Batch", 0));
+
+    if (renderer.texturePool.textures.data() == before)
+    {
+        printf("The distance field page did not reallocate the texture pool, the test is not exercising anything\n");
+        passed = false;
+    }
+
+    passed = CheckQueuedSprite("RenderSdfText", sprite, spriteSet) && passed;
+
+    RenderSdfText(handle, "Batch", { 10.0f, 120.0f }, 48.0f);
+    passed = CheckSpriteFlushed("RenderSdfText", sprite) && passed;
+
+    RendererEndFrame();
+
+    for (Texture *filler : fillers)
+    {
+        DestroyTexture(filler);
+    }
+
+    DestroyTexture(sprite);
+    DestroyFont(handle);
+
+    RendererShutdown();
+    DestroyWindow(window);
+
+    printf("%s\n", passed ? "Passed" : "Failed");
+    return passed ? 0 : 1;
+}
\ No newline at end of file
@@ -0,0 +1,162 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <string>
+#include <vector>
+#include <algorithm>
+
+#include <stb_image.h>
+
+#include "Renderer.h"
+#include "AssetPackFormat.h"
+
+// Usage: vk2d-packer <output.pak> <image>[@rgba8|@r8|@rg8] ...
+//
+// Each image is decoded once here and stored under the path it was given on
+// the command line, which is also the name passed to LoadTextureFromPack.
+
+struct PackInput
+{
+    std::string name;
+    TextureFormat format;
+    int channels;
+
+    int width, height;
+    stbi_uc *pixels;
+};
+
+static bool ParseInput(const char *arg, PackInput *input)
+{
+    input->name = arg;
+    input->format = TextureFormatRGBA8;
+    input->channels = 4;
+
+    size_t at = input->name.rfind('@');
+    if (at != std::string::npos)
+    {
+        std::string suffix = input->name.substr(at + 1);
+        input->name = input->name.substr(0, at);
+
+        if (suffix == "rgba8")
+        {
+            input->format = TextureFormatRGBA8;
+            input->channels = 4;
+        }
+        else if (suffix == "r8")
+        {
+            input->format = TextureFormatR8;
+            input->channels = 1;
+        }
+        else if (suffix == "rg8")
+        {
+            input->format = TextureFormatRG8;
+            input->channels = 2;
+        }
+        else
+        {
+            printf("Unknown format suffix: %s\n", suffix.c_str());
+            return false;
+        }
+    }
+
+    if (input->name.size() >= ASSET_PACK_NAME_LENGTH)
+    {
+        printf("Asset name is longer than %d characters: %s\n", ASSET_PACK_NAME_LENGTH - 1, input->name.c_str());
+        return false;
+    }
+
+    return true;
+}
+
+static uint64_t AlignOffset(uint64_t offset)
+{
+    return (offset + ASSET_PACK_DATA_ALIGNMENT - 1) & ~(uint64_t)(ASSET_PACK_DATA_ALIGNMENT - 1);
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 3)
+    {
+        printf("Usage: %s <output.pak> <image>[@rgba8|@r8|@rg8] ...\n", argv[0]);
+        return 1;
+    }
+
+    // Match the orientation RendererInit sets for runtime loads
+    stbi_set_flip_vertically_on_load(true);
+
+    std::vector<PackInput> inputs(argc - 2);
+    for (int i = 2; i < argc; ++i)
+    {
+        PackInput &input = inputs[i - 2];
+        if (!ParseInput(argv[i], &input))
+            return 1;
+
+        int channels;
+        input.pixels = stbi_load(input.name.c_str(), &input.width, &input.height, &channels, input.channels);
+        if (!input.pixels)
+        {
+            printf("Failed to load image: %s (%s)\n", input.name.c_str(), stbi_failure_reason());
+            return 1;
+        }
+    }
+
+    std::vector<AssetPackEntry> entries(inputs.size());
+    uint64_t offset = AlignOffset(sizeof(AssetPackHeader) + entries.size() * sizeof(AssetPackEntry));
+
+    for (size_t i = 0; i < inputs.size(); ++i)
+    {
+        AssetPackEntry &entry = entries[i];
+        memset(&entry, 0, sizeof(entry));
+
+        strncpy(entry.name, inputs[i].name.c_str(), ASSET_PACK_NAME_LENGTH - 1);
+        entry.nameHash = HashAssetName(entry.name);
+        entry.format = (uint32_t)inputs[i].format;
+        entry.width = (uint32_t)inputs[i].width;
+        entry.height = (uint32_t)inputs[i].height;
+        entry.offset = offset;
+        entry.size = (uint64_t)inputs[i].width * inputs[i].height * inputs[i].channels;
+
+        offset = AlignOffset(offset + entry.size);
+    }
+
+    // Data is written in input order, the index is sorted for lookups
+    std::vector<AssetPackEntry> index = entries;
+    std::stable_sort(index.begin(), index.end(), [](const AssetPackEntry &a, const AssetPackEntry &b)
+    {
+        return a.nameHash < b.nameHash;
+    });
+
+    FILE *file = fopen(argv[1], "wb");
+    if (!file)
+    {
+        printf("Failed to open output file: %s\n", argv[1]);
+        return 1;
+    }
+
+    AssetPackHeader header = {};
+    header.magic = ASSET_PACK_MAGIC;
+    header.version = ASSET_PACK_VERSION;
+    header.entryCount = (uint32_t)index.size();
+
+    fwrite(&header, sizeof(header), 1, file);
+    fwrite(index.data(), sizeof(AssetPackEntry), index.size(), file);
+
+    static const uint8_t padding[ASSET_PACK_DATA_ALIGNMENT] = {};
+
+    for (size_t i = 0; i < inputs.size(); ++i)
+    {
+        long position = ftell(file);
+        fwrite(padding, 1, (size_t)(entries[i].offset - position), file);
+
+        fwrite(inputs[i].pixels, 1, (size_t)entries[i].size, file);
+
+        stbi_image_free(inputs[i].pixels);
+    }
+
+    fclose(file);
+
+    printf("Packed %d textures into %s\n", (int)inputs.size(), argv[1]);
+
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,179 @@
+#include <stdio.h>
+#include <ctype.h>
+
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <glslang/Public/ShaderLang.h>
+
+#include "GlslCompiler.h"
+#include "ShaderReflection.h"
+
+// Usage: vk2d-shaderc <output.h> <shader.vert|shader.frag> ...
+//
+// Compiles every shader with the same glslang setup the runtime uses and writes
+// a header holding the SPIR-V and reflection tables, which the library picks up
+// through CreateShaderFromEmbedded when built with VK2D_EMBED_SHADERS.
+
+static std::string GetFileName(const std::string &path)
+{
+    size_t found = path.find_last_of("/\\");
+    return found == std::string::npos ? path : path.substr(found + 1);
+}
+
+static std::string GetIdentifier(const std::string &name)
+{
+    std::string identifier = name;
+    for (char &c : identifier)
+    {
+        if (!isalnum((unsigned char)c))
+            c = '_';
+    }
+
+    return identifier;
+}
+
+static bool WriteShader(FILE *out, const std::string &path, std::string *entry)
+{
+    std::ifstream file(path);
+    if (!file.is_open())
+    {
+        printf("Failed to open file: %s\n", path.c_str());
+        return false;
+    }
+
+    std::string source((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+    std::vector<uint32_t> spirv;
+    std::vector<ShaderInclude> includes;
+    std::string log;
+
+    if (!CompileGlslToSpirv(path, source, "", true, &spirv, &includes, &log))
+    {
+        printf("%s\n", log.c_str());
+        return false;
+    }
+
+    ShaderReflection reflection;
+    ReflectionStorage storage;
+    if (!ReflectSpirv(spirv.data(), spirv.size() * sizeof(uint32_t), &reflection, &storage))
+    {
+        printf("Failed to reflect %s\n", path.c_str());
+        return false;
+    }
+
+    std::string name = GetFileName(path);
+    std::string identifier = GetIdentifier(name);
+
+    fprintf(out, "static const uint32_t %s_code[] = {", identifier.c_str());
+    for (size_t i = 0; i < spirv.size(); ++i)
+    {
+        fprintf(out, "%s0x%08x,", i % 8 == 0 ? "\n    " : " ", spirv[i]);
+    }
+    fprintf(out, "\n};\n\n");
+
+    // Zero length arrays are not valid C++, so empty tables get a placeholder entry
+    fprintf(out, "static const ReflectedAttribute %s_attributes[] = {\n", identifier.c_str());
+    for (const ReflectedAttribute &attribute : storage.attributes)
+    {
+        fprintf(out, "    { %u, (VkFormat)%d, %u },\n", attribute.location, (int)attribute.format, attribute.offset);
+    }
+    if (storage.attributes.empty())
+        fprintf(out, "    {}\n");
+    fprintf(out, "};\n\n");
+
+    fprintf(out, "static const ReflectedBinding %s_bindings[] = {\n", identifier.c_str());
+    for (const ReflectedBinding &binding : storage.bindings)
+    {
+        fprintf(out, "    { %u, %u, (VkDescriptorType)%d, %u },\n", binding.set, binding.binding, (int)binding.type, binding.count);
+    }
+    if (storage.bindings.empty())
+        fprintf(out, "    {}\n");
+    fprintf(out, "};\n\n");
+
+    fprintf(out, "static const ReflectedMember %s_members[] = {\n", identifier.c_str());
+    for (const ReflectedMember &member : storage.members)
+    {
+        fprintf(out, "    { \"%s\", %u, %u, %u, %u, %u, %s },\n", member.name, member.set, member.binding, member.offset, member.size, member.components, member.integer ? "true" : "false");
+    }
+    if (storage.members.empty())
+        fprintf(out, "    {}\n");
+    fprintf(out, "};\n\n");
+
+    char buffer[1024];
+    snprintf(buffer, sizeof(buffer),
+        "    { \"%s\", %s_code, sizeof(%s_code), { (VkShaderStageFlagBits)%d, %s_attributes, %u, %u, %s_bindings, %u, %u, %u, 0x%x, %s_members, %u } },\n",
+        name.c_str(), identifier.c_str(), identifier.c_str(), (int)reflection.stage,
+        identifier.c_str(), reflection.attributeCount, reflection.vertexStride,
+        identifier.c_str(), reflection.bindingCount, reflection.setCount,
+        reflection.pushConstantSize, reflection.specConstantMask,
+        identifier.c_str(), reflection.memberCount);
+
+    *entry = buffer;
+
+    return true;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 3)
+    {
+        printf("Usage: vk2d-shaderc <output.h> <shader.vert|shader.frag> ...\n");
+        return 1;
+    }
+
+    glslang::InitializeProcess();
+
+    // Written under a temporary name so a failed compile never leaves a half written header behind
+    std::string outputPath = argv[1];
+    std::string tempPath = outputPath + ".tmp";
+
+    FILE *out = fopen(tempPath.c_str(), "w");
+    if (!out)
+    {
+        printf("Failed to open output file: %s\n", tempPath.c_str());
+        return 1;
+    }
+
+    fprintf(out, "#pragma once\n\n// Generated by vk2d-shaderc, do not edit\n\n#include \"ShaderReflection.h\"\n\n");
+
+    std::vector<std::string> entries;
+    bool failed = false;
+
+    for (int i = 2; i < argc && !failed; ++i)
+    {
+        std::string entry;
+        failed = !WriteShader(out, argv[i], &entry);
+        entries.push_back(entry);
+    }
+
+    if (!failed)
+    {
+        fprintf(out, "static const EmbeddedShader embeddedShaders[] = {\n");
+        for (const std::string &entry : entries)
+        {
+            fprintf(out, "%s", entry.c_str());
+        }
+        fprintf(out, "};\n\nstatic const uint32_t embeddedShaderCount = %u;\n", (uint32_t)entries.size());
+    }
+
+    fclose(out);
+
+    glslang::FinalizeProcess();
+
+    if (failed)
+    {
+        remove(tempPath.c_str());
+        return 1;
+    }
+
+    remove(outputPath.c_str());
+    if (rename(tempPath.c_str(), outputPath.c_str()) != 0)
+    {
+        printf("Failed to write output file: %s\n", outputPath.c_str());
+        return 1;
+    }
+
+    return 0;
+}
\ No newline at end of file
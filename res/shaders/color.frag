@@ -1,16 +1,12 @@
 #version 460
 #extension GL_ARB_separate_shader_objects : enable
+#extension GL_GOOGLE_include_directive : require
 
-layout (location = 0) out vec4 outColor;
+#include "draw.glsl"
 
-layout (push_constant) uniform PushConstant
-{
-    mat4 model;
-    vec4 texCoord;
-    vec4 color;
-};
+layout (location = 0) out vec4 outColor;
 
 void main()
 {
-    outColor = color;
+    outColor = GetDrawColor();
 }
\ No newline at end of file
@@ -0,0 +1,26 @@
+// Per-draw data, matches DrawData in src/DrawData.h. Shared by the built-in shaders and materials.
+layout (push_constant) uniform PushConstant
+{
+    vec2 axisX;
+    vec2 axisY;
+    vec2 origin;
+    uint texPos;
+    uint texSize;
+    uint color;
+};
+
+vec2 TransformVertex(vec2 vertPos)
+{
+    return origin + axisX * vertPos.x + axisY * vertPos.y;
+}
+
+// The unit quad's y runs opposite to the texture's v
+vec2 GetVertexUv(vec2 vertPos)
+{
+    return unpackUnorm2x16(texPos) + vec2(vertPos.x, 1.0 - vertPos.y) * unpackUnorm2x16(texSize);
+}
+
+vec4 GetDrawColor()
+{
+    return unpackUnorm4x8(color);
+}
\ No newline at end of file
@@ -0,0 +1,98 @@
+#version 460
+#extension GL_ARB_separate_shader_objects : enable
+
+// Matches BatchShape and SHAPE_PADDING in src/SpriteBatch.h, and MSDF_RANGE in src/Font.h
+#define SHAPE_SPRITE 0
+#define SHAPE_CIRCLE 1
+#define SHAPE_ROUNDED_RECT 2
+#define SHAPE_MSDF_GLYPH 3
+#define SHAPE_PADDING 1.0
+#define MSDF_RANGE 4.0
+
+layout (location = 0) in vec2 fragUv;
+layout (location = 1) in vec4 fragColor;
+layout (location = 2) flat in vec2 fragHalfSize;
+layout (location = 3) flat in vec2 fragShapeParams;
+layout (location = 4) flat in uint fragShape;
+
+layout (location = 0) out vec4 outColor;
+
+layout (binding = 0, set = 1) uniform sampler2D tex;
+
+layout (constant_id = 0) const bool alphaTest = false;
+
+float RoundedRectDistance(vec2 p, vec2 halfSize, float radius)
+{
+    vec2 q = abs(p) - halfSize + radius;
+    return length(max(q, 0.0)) + min(max(q.x, q.y), 0.0) - radius;
+}
+
+// Fraction of the pixel covered by the shape, the edge is blended over one pixel in screen space
+float ShapeCoverage()
+{
+    // Shape quads have full uvs, so they map straight onto the quad
+    vec2 p = (fragUv * 2.0 - 1.0) * fragHalfSize;
+    vec2 halfSize = fragHalfSize - SHAPE_PADDING;
+
+    float radius = fragShapeParams.x;
+    float thickness = fragShapeParams.y;
+
+    float d;
+    if (fragShape == SHAPE_CIRCLE)
+        d = length(p) - min(halfSize.x, halfSize.y);
+    else
+        d = RoundedRectDistance(p, halfSize, min(radius, min(halfSize.x, halfSize.y)));
+
+    // Outlines keep the band of the given thickness inside the edge
+    if (thickness > 0.0)
+        d = abs(d + thickness * 0.5) - thickness * 0.5;
+
+    return clamp(0.5 - d / max(fwidth(d), 1e-4), 0.0, 1.0);
+}
+
+float Median(vec3 v)
+{
+    return max(min(v.r, v.g), min(max(v.r, v.g), v.b));
+}
+
+// Fraction of the pixel inside the glyph, the field is in atlas texels and the edge is blended over one
+// screen pixel at any scale
+float GlyphCoverage()
+{
+    vec4 field = texture(tex, fragUv);
+
+    vec2 texelsPerPixel = fwidth(fragUv) * vec2(textureSize(tex, 0));
+    float pixelsPerTexel = 2.0 / max(texelsPerPixel.x + texelsPerPixel.y, 1e-4);
+
+    // Past MSDF_RANGE the field is clamped and reads the same everywhere, so the blended edge has to end
+    // before it or the whole quad would show
+    float reach = max(MSDF_RANGE - 0.5 / pixelsPerTexel, 0.0);
+    float grow = min(fragShapeParams.x, reach);
+    float softness = min(fragShapeParams.y, 2.0 * (reach - grow));
+
+    // The median of the channels keeps corners sharp on the outline itself. Grown and softened layers
+    // use the true distance in alpha, which stays valid away from the outline.
+    float value = grow > 0.0 || softness > 0.0 ? field.a : Median(field.rgb);
+    float d = (value - 0.5) * 2.0 * MSDF_RANGE + grow;
+
+    return clamp(d * pixelsPerTexel / (1.0 + softness * pixelsPerTexel) + 0.5, 0.0, 1.0);
+}
+
+void main()
+{
+    if (fragShape == SHAPE_MSDF_GLYPH)
+    {
+        // The texture holds distances, not colors
+        outColor = vec4(fragColor.rgb, fragColor.a * GlyphCoverage());
+    }
+    else
+    {
+        outColor = texture(tex, fragUv) * fragColor;
+
+        if (fragShape != SHAPE_SPRITE)
+            outColor.a *= ShapeCoverage();
+    }
+
+    if (alphaTest && outColor.a < 0.5)
+        discard;
+}
\ No newline at end of file
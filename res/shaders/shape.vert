@@ -0,0 +1,38 @@
+#version 460
+#extension GL_ARB_separate_shader_objects : enable
+
+// Batched sprites and shapes, positions are already transformed on the CPU. The vertices are the plain
+// BatchVertex of sprite.vert, each quad reads its BatchShapeData (src/SpriteBatch.h) by vertex index.
+layout (location = 0) in vec2 vertPos;
+layout (location = 1) in uint vertUv;
+layout (location = 2) in uint vertColor;
+
+layout (location = 0) out vec2 fragUv;
+layout (location = 1) out vec4 fragColor;
+layout (location = 2) flat out vec2 fragHalfSize;
+layout (location = 3) flat out vec2 fragShapeParams;
+layout (location = 4) flat out uint fragShape;
+
+layout (binding = 0, set = 0) uniform Camera
+{
+    mat4 projection;
+};
+
+// Parallel to the vertex ring, one record per four vertices
+layout (binding = 0, set = 2) readonly buffer Shapes
+{
+    uvec4 shapes[];
+};
+
+void main()
+{
+    gl_Position = projection * vec4(vertPos, 0.0, 1.0);
+
+    uvec4 shape = shapes[gl_VertexIndex / 4];
+
+    fragUv = unpackUnorm2x16(vertUv);
+    fragColor = unpackUnorm4x8(vertColor);
+    fragHalfSize = uintBitsToFloat(shape.xy);
+    fragShapeParams = unpackHalf2x16(shape.z);
+    fragShape = shape.w;
+}
\ No newline at end of file
@@ -0,0 +1,19 @@
+#version 460
+#extension GL_ARB_separate_shader_objects : enable
+
+layout (location = 0) in vec2 fragUv;
+layout (location = 1) in vec4 fragColor;
+
+layout (location = 0) out vec4 outColor;
+
+layout (binding = 0, set = 1) uniform sampler2D tex;
+
+layout (constant_id = 0) const bool alphaTest = false;
+
+void main()
+{
+    outColor = texture(tex, fragUv) * fragColor;
+
+    if (alphaTest && outColor.a < 0.5)
+        discard;
+}
\ No newline at end of file
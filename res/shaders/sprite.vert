@@ -0,0 +1,23 @@
+#version 460
+#extension GL_ARB_separate_shader_objects : enable
+
+// Batched geometry, positions are already transformed on the CPU. See BatchVertex in src/SpriteBatch.h.
+layout (location = 0) in vec2 vertPos;
+layout (location = 1) in uint vertUv;
+layout (location = 2) in uint vertColor;
+
+layout (location = 0) out vec2 fragUv;
+layout (location = 1) out vec4 fragColor;
+
+layout (binding = 0, set = 0) uniform Camera
+{
+    mat4 projection;
+};
+
+void main()
+{
+    gl_Position = projection * vec4(vertPos, 0.0, 1.0);
+
+    fragUv = unpackUnorm2x16(vertUv);
+    fragColor = unpackUnorm4x8(vertColor);
+}
\ No newline at end of file
@@ -1,5 +1,8 @@
 #version 460
 #extension GL_ARB_separate_shader_objects : enable
+#extension GL_GOOGLE_include_directive : require
+
+#include "draw.glsl"
 
 layout (location = 0) in vec2 fragUv;
 
@@ -7,14 +10,12 @@ layout (location = 0) out vec4 outColor;
 
 layout (binding = 0, set = 1) uniform sampler2D tex;
 
-layout (push_constant) uniform PushConstant
-{
-    mat4 model;
-    vec4 texCoord;
-    vec4 color;
-};
+layout (constant_id = 0) const bool alphaTest = false;
 
 void main()
 {
-    outColor = texture(tex, fragUv) * color;
+    outColor = texture(tex, fragUv) * GetDrawColor();
+
+    if (alphaTest && outColor.a < 0.5)
+        discard;
 }
\ No newline at end of file
@@ -0,0 +1,121 @@
+#include "Renderer.h"
+
+#include "Internal.h"
+#include "Utils.h"
+#include "AssetPackFormat.h"
+
+#include <string.h>
+
+struct AssetPack
+{
+    MappedFile file;
+
+    const AssetPackHeader *header;
+    const AssetPackEntry *entries;
+};
+
+AssetPack *OpenAssetPack(const char *filename)
+{
+    AssetPack *pack = (AssetPack *)calloc(1, sizeof(AssetPack));
+
+    if (!PlatformMapFile(&pack->file, filename))
+    {
+        printf("Failed to open asset pack: %s\n", filename);
+
+        free(pack);
+        return nullptr;
+    }
+
+    pack->header = (const AssetPackHeader *)pack->file.data;
+    pack->entries = (const AssetPackEntry *)(pack->file.data + sizeof(AssetPackHeader));
+
+    bool valid = pack->file.size >= sizeof(AssetPackHeader) &&
+        pack->header->magic == ASSET_PACK_MAGIC &&
+        pack->header->version == ASSET_PACK_VERSION &&
+        pack->file.size >= sizeof(AssetPackHeader) + pack->header->entryCount * sizeof(AssetPackEntry);
+
+    if (!valid)
+    {
+        printf("Invalid or outdated asset pack: %s\n", filename);
+
+        PlatformUnmapFile(&pack->file);
+        free(pack);
+        return nullptr;
+    }
+
+    return pack;
+}
+
+void CloseAssetPack(AssetPack *pack)
+{
+    PlatformUnmapFile(&pack->file);
+
+    free(pack);
+}
+
+static const AssetPackEntry *FindAssetPackEntry(AssetPack *pack, const char *name)
+{
+    uint64_t hash = HashAssetName(name);
+
+    uint32_t low = 0;
+    uint32_t high = pack->header->entryCount;
+    while (low < high)
+    {
+        uint32_t mid = low + (high - low) / 2;
+        if (pack->entries[mid].nameHash < hash)
+            low = mid + 1;
+        else
+            high = mid;
+    }
+
+    for (uint32_t i = low; i < pack->header->entryCount && pack->entries[i].nameHash == hash; ++i)
+    {
+        if (strncmp(pack->entries[i].name, name, ASSET_PACK_NAME_LENGTH) == 0)
+            return &pack->entries[i];
+    }
+
+    return nullptr;
+}
+
+Texture *LoadTextureFromPack(AssetPack *pack, const char *name)
+{
+    const AssetPackEntry *entry = FindAssetPackEntry(pack, name);
+    if (!entry)
+    {
+        printf("Asset pack has no texture named: %s\n", name);
+        return nullptr;
+    }
+
+    // The format comes straight from the file, so it is range checked before it is converted
+    bool valid = entry->format < TextureFormatCount;
+
+    VkFormat format = valid ? GetTextureVkFormat((TextureFormat)entry->format) : VK_FORMAT_UNDEFINED;
+    // Checked against the space left after offset, offset + size could wrap around
+    valid = valid && entry->offset <= pack->file.size && entry->size <= pack->file.size - entry->offset;
+    valid = valid && entry->size == (uint64_t)entry->width * entry->height * GetFormatTexelSize(format);
+
+    if (!valid)
+    {
+        printf("Corrupt asset pack entry: %s\n", name);
+        __debugbreak();
+        return nullptr;
+    }
+
+    Texture *handle;
+    _Texture *texture = AllocateTexture(&handle);
+
+    texture->width = entry->width;
+    texture->height = entry->height;
+
+    texture->format = format;
+
+    // The texel data is already GPU ready, so it is copied straight out of the mapping into the staging buffer
+    _CreateTexture(texture, texture->width, texture->height, texture->format, pack->file.data + entry->offset, VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT);
+
+    texture->framebuffer = VK_NULL_HANDLE;
+
+    // Evicting this texture only needs to drop the image, the pack still holds the texels
+    texture->sourcePixels = pack->file.data + entry->offset;
+
+    return handle;
+}
\ No newline at end of file
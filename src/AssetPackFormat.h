@@ -0,0 +1,52 @@
+#pragma once
+
+#include <stdint.h>
+
+// On-disk layout shared by the runtime and the offline packer (Tools/Packer).
+//
+//   AssetPackHeader
+//   AssetPackEntry[entryCount]    sorted by nameHash
+//   texel data                    each blob aligned to ASSET_PACK_DATA_ALIGNMENT
+//
+// Texel data is stored exactly as the GPU expects it for the entry's format,
+// tightly packed and already flipped bottom up the way LoadTextureFromFile uploads images.
+
+#define ASSET_PACK_MAGIC 0x4B50324B // "K2PK"
+#define ASSET_PACK_VERSION 1
+
+#define ASSET_PACK_NAME_LENGTH 64
+#define ASSET_PACK_DATA_ALIGNMENT 16
+
+struct AssetPackHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t entryCount;
+    uint32_t reserved;
+};
+
+struct AssetPackEntry
+{
+    char name[ASSET_PACK_NAME_LENGTH];
+    uint64_t nameHash;
+
+    uint32_t format; // TextureFormat
+    uint32_t width, height;
+    uint32_t reserved;
+
+    uint64_t offset;
+    uint64_t size;
+};
+
+inline uint64_t HashAssetName(const char *name)
+{
+    // FNV-1a
+    uint64_t hash = 14695981039346656037ull;
+    for (const char *c = name; *c; ++c)
+    {
+        hash ^= (uint8_t)*c;
+        hash *= 1099511628211ull;
+    }
+
+    return hash;
+}
\ No newline at end of file
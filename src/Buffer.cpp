@@ -3,6 +3,8 @@
 #include "Internal.h"
 #include "Utils.h"
 
+#include <string.h>
+
 void CreateBuffer(Buffer *buffer, uint32_t size, VkBufferUsageFlags usage, VmaMemoryUsage memUsage, bool createMapped /* = false */)
 {
     buffer->size = size;
@@ -26,6 +28,55 @@ void CreateBuffer(Buffer *buffer, uint32_t size, VkBufferUsageFlags usage, VmaMe
     VkCheck(vmaCreateBuffer(renderer.allocator, &bufferInfo, &allocInfo, &buffer->buffer, &buffer->allocation, nullptr));
 }
 
+void CreateStaticBuffer(Buffer *buffer, const void *data, uint32_t size, VkBufferUsageFlags usage)
+{
+    CreateBuffer(buffer, size, usage | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VMA_MEMORY_USAGE_GPU_ONLY);
+
+    StagingAllocation staging = AllocateStaging(size, 16);
+    memcpy(staging.mapped, data, size);
+
+    VkCommandBuffer cmdBuffer = GetUploadCommandBuffer();
+
+    VkBufferCopy region = {};
+    region.srcOffset = staging.offset;
+    region.dstOffset = 0;
+    region.size = size;
+
+    vkCmdCopyBuffer(cmdBuffer, staging.buffer, buffer->buffer, 1, &region);
+
+    VkAccessFlags dstAccess = 0;
+    VkPipelineStageFlags dstStage = 0;
+    if (usage & VK_BUFFER_USAGE_VERTEX_BUFFER_BIT)
+    {
+        dstAccess |= VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT;
+        dstStage |= VK_PIPELINE_STAGE_VERTEX_INPUT_BIT;
+    }
+    if (usage & VK_BUFFER_USAGE_INDEX_BUFFER_BIT)
+    {
+        dstAccess |= VK_ACCESS_INDEX_READ_BIT;
+        dstStage |= VK_PIPELINE_STAGE_VERTEX_INPUT_BIT;
+    }
+    if (usage & VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT)
+    {
+        dstAccess |= VK_ACCESS_UNIFORM_READ_BIT;
+        dstStage |= VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+    }
+    if (dstStage == 0)
+        dstStage = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+
+    VkBufferMemoryBarrier barrier = {};
+    barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask = dstAccess;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.buffer = buffer->buffer;
+    barrier.offset = 0;
+    barrier.size = VK_WHOLE_SIZE;
+
+    vkCmdPipelineBarrier(cmdBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, dstStage, 0, 0, nullptr, 1, &barrier, 0, nullptr);
+}
+
 void DestroyBuffer(Buffer *buffer)
 {
     vmaDestroyBuffer(renderer.allocator, buffer->buffer, buffer->allocation);
@@ -13,6 +13,10 @@ struct Buffer
 };
 
 void CreateBuffer(Buffer *buffer, uint32_t size, VkBufferUsageFlags usage, VmaMemoryUsage memUsage, bool createMapped = false);
+
+// Device local and never written again. data goes through the frame's staging ring, the copy is submitted
+// ahead of this frame's draws so the buffer can be drawn from right away.
+void CreateStaticBuffer(Buffer *buffer, const void *data, uint32_t size, VkBufferUsageFlags usage);
 void DestroyBuffer(Buffer *buffer);
 
 void *MapBufferMemory(Buffer *buffer);
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <stdint.h>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/packing.hpp>
+
+// Per-draw data as the shaders read it from their push constants, see res/shaders/draw.glsl.
+// 36 bytes against the 96 of a mat4 model with float texCoord and color.
+struct DrawData
+{
+    // Columns of the 2x3 affine transform applied to the unit quad or line
+    glm::vec2 axisX;
+    glm::vec2 axisY;
+    glm::vec2 origin;
+
+    // Normalized uv offset and size as 16 bit unorm pairs, so coordinates outside [0, 1] are clamped
+    uint32_t texPos;
+    uint32_t texSize;
+
+    // RGBA8 unorm, red in the lowest byte
+    uint32_t color;
+};
+
+static_assert(sizeof(DrawData) == 36, "DrawData must match the push constant block in draw.glsl");
+
+inline uint32_t PackColor(glm::vec4 color)
+{
+    return glm::packUnorm4x8(color);
+}
+
+// Axis aligned, the rect's size goes straight into the axes with no matrix math
+inline DrawData MakeDrawData(glm::vec2 pos, glm::vec2 size, glm::vec4 texCoord, glm::vec4 color)
+{
+    DrawData data;
+    data.axisX = { size.x, 0.0f };
+    data.axisY = { 0.0f, size.y };
+    data.origin = pos;
+    data.texPos = glm::packUnorm2x16({ texCoord.x, texCoord.y });
+    data.texSize = glm::packUnorm2x16({ texCoord.z, texCoord.w });
+    data.color = PackColor(color);
+
+    return data;
+}
\ No newline at end of file
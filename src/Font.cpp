@@ -0,0 +1,606 @@
+#include "Renderer.h"
+
+#include "Font.h"
+#include "Hash.h"
+#include "JobSystem.h"
+#include "Msdf.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static std::vector<GlyphPage> pages;
+static std::vector<GlyphCell> cells;
+static GlyphCellClass cellClasses[GLYPH_CELL_CLASSES];
+
+// Keyed by font id, pixel size and glyph, see GetGlyphKey
+static std::unordered_map<uint64_t, uint32_t> glyphLookup;
+
+static std::vector<MsdfPage> msdfPages;
+static std::vector<MsdfGlyph> msdfGlyphs;
+
+// Keyed by font id and glyph
+static std::unordered_map<uint64_t, uint32_t> msdfLookup;
+
+static uint32_t nextFontId = 1;
+
+Font *LoadFontFromFile(const char *filename)
+{
+    _Font *font = new _Font();
+
+    if (!PlatformMapFile(&font->file, filename))
+    {
+        printf("Failed to open font: %s\n", filename);
+
+        delete font;
+        return nullptr;
+    }
+
+    if (!ParseTrueType(&font->ttf, font->file.data, (uint32_t)font->file.size))
+    {
+        printf("Invalid or unsupported font: %s\n", filename);
+
+        PlatformUnmapFile(&font->file);
+        delete font;
+        return nullptr;
+    }
+
+    font->id = nextFontId++;
+
+    return (Font *)font;
+}
+
+static void UnlinkCell(uint32_t index)
+{
+    GlyphCell &cell = cells[index];
+    GlyphCellClass &cellClass = cellClasses[pages[cell.page].cellClass];
+
+    if (cell.previous != GLYPH_NONE)
+        cells[cell.previous].next = cell.next;
+    else
+        cellClass.head = cell.next;
+
+    if (cell.next != GLYPH_NONE)
+        cells[cell.next].previous = cell.previous;
+    else
+        cellClass.tail = cell.previous;
+}
+
+static void LinkCellFront(uint32_t index)
+{
+    GlyphCell &cell = cells[index];
+    GlyphCellClass &cellClass = cellClasses[pages[cell.page].cellClass];
+
+    cell.previous = GLYPH_NONE;
+    cell.next = cellClass.head;
+
+    if (cellClass.head != GLYPH_NONE)
+        cells[cellClass.head].previous = index;
+    else
+        cellClass.tail = index;
+
+    cellClass.head = index;
+}
+
+// Free cells wait at the tail, so they are taken before anything is evicted
+static void LinkCellBack(uint32_t index)
+{
+    GlyphCell &cell = cells[index];
+    GlyphCellClass &cellClass = cellClasses[pages[cell.page].cellClass];
+
+    cell.previous = cellClass.tail;
+    cell.next = GLYPH_NONE;
+
+    if (cellClass.tail != GLYPH_NONE)
+        cells[cellClass.tail].next = index;
+    else
+        cellClass.head = index;
+
+    cellClass.tail = index;
+}
+
+void DestroyFont(Font *handle)
+{
+    _Font *font = (_Font *)handle;
+
+    // Its glyphs stay in the pages until overwritten, draws recorded this frame still show them
+    for (uint32_t i = 0; i < cells.size(); ++i)
+    {
+        if (cells[i].key == 0 || (uint32_t)(cells[i].key >> 32) != font->id)
+            continue;
+
+        glyphLookup.erase(cells[i].key);
+        cells[i].key = 0;
+
+        UnlinkCell(i);
+        LinkCellBack(i);
+    }
+
+    // Distance field glyphs are never evicted, their space is lost until ShutdownFonts
+    for (auto it = msdfLookup.begin(); it != msdfLookup.end();)
+    {
+        if ((uint32_t)(it->first >> 32) == font->id)
+            it = msdfLookup.erase(it);
+        else
+            ++it;
+    }
+
+    PlatformUnmapFile(&font->file);
+    delete font;
+}
+
+uint32_t GetFontPixelSize(float size)
+{
+    uint32_t pixelSize = (uint32_t)(size + 0.5f);
+
+    if (pixelSize < 1)
+        return 1;
+    if (pixelSize > GLYPH_MAX_PIXEL_SIZE)
+        return GLYPH_MAX_PIXEL_SIZE;
+
+    return pixelSize;
+}
+
+// Invalid sequences decode to the replacement character, a truncated one stops at the terminator
+static uint32_t DecodeUtf8(const char **text)
+{
+    const uint8_t *bytes = (const uint8_t *)*text;
+    uint32_t lead = bytes[0];
+
+    uint32_t length = 0;
+    if (lead < 0x80)
+        length = 1;
+    else if ((lead >> 5) == 0x06)
+        length = 2;
+    else if ((lead >> 4) == 0x0E)
+        length = 3;
+    else if ((lead >> 3) == 0x1E)
+        length = 4;
+
+    if (length == 0)
+    {
+        *text += 1;
+        return 0xFFFD;
+    }
+
+    uint32_t codepoint = length == 1 ? lead : lead & (0xFF >> (length + 1));
+    for (uint32_t i = 1; i < length; ++i)
+    {
+        if ((bytes[i] & 0xC0) != 0x80)
+        {
+            *text += i;
+            return 0xFFFD;
+        }
+
+        codepoint = codepoint << 6 | (bytes[i] & 0x3F);
+    }
+
+    *text += length;
+    return codepoint;
+}
+
+static void TrimLayouts(_Font *font)
+{
+    for (auto it = font->layouts.begin(); it != font->layouts.end();)
+    {
+        if (it->second.lastUsedFrame < renderer.frameCounter)
+            it = font->layouts.erase(it);
+        else
+            ++it;
+    }
+}
+
+const TextLayout &GetTextLayout(_Font *font, const char *text, uint32_t pixelSize)
+{
+    size_t length = strlen(text);
+    uint64_t key = HashMemory(text, length, pixelSize);
+
+    auto it = font->layouts.find(key);
+    if (it != font->layouts.end() && it->second.pixelSize == pixelSize && it->second.text.compare(0, std::string::npos, text, length) == 0)
+    {
+        it->second.lastUsedFrame = renderer.frameCounter;
+        return it->second;
+    }
+
+    if (font->layouts.size() >= TEXT_LAYOUT_CACHE_SIZE)
+        TrimLayouts(font);
+
+    // A colliding entry is simply replaced
+    TextLayout &layout = font->layouts[key];
+    layout.text.assign(text, length);
+    layout.pixelSize = pixelSize;
+    layout.glyphs.clear();
+    layout.lastUsedFrame = renderer.frameCounter;
+
+    const TrueTypeFont &ttf = font->ttf;
+
+    float scale = (pixelSize ? (float)pixelSize : 1.0f) / (float)ttf.unitsPerEm;
+    float ascent = ttf.ascender * scale;
+    float lineHeight = (ttf.ascender - ttf.descender + ttf.lineGap) * scale;
+
+    if (pixelSize)
+    {
+        ascent = roundf(ascent);
+        lineHeight = roundf(lineHeight);
+    }
+
+    glm::vec2 pen = { 0.0f, ascent };
+    float width = 0.0f;
+
+    uint32_t previous = GLYPH_NONE;
+
+    const char *cursor = text;
+    while (cursor < text + length)
+    {
+        uint32_t codepoint = DecodeUtf8(&cursor);
+
+        if (codepoint == '\n')
+        {
+            width = fmaxf(width, pen.x);
+
+            pen.x = 0.0f;
+            pen.y += lineHeight;
+
+            previous = GLYPH_NONE;
+            continue;
+        }
+
+        uint32_t glyph = FindGlyph(&ttf, codepoint);
+
+        if (previous != GLYPH_NONE)
+            pen.x += GetKerning(&ttf, previous, glyph) * scale;
+
+        if (!IsGlyphEmpty(&ttf, glyph))
+            layout.glyphs.push_back({ glyph, pen });
+
+        int32_t advance, leftBearing;
+        GetGlyphMetrics(&ttf, glyph, &advance, &leftBearing);
+
+        pen.x += advance * scale;
+        previous = glyph;
+    }
+
+    layout.extent = { fmaxf(width, pen.x), pen.y - ascent + lineHeight };
+
+    return layout;
+}
+
+static bool AddGlyphPage(uint32_t cellClass)
+{
+    if (pages.size() >= GLYPH_MAX_PAGES)
+        return false;
+
+    GlyphPage page = {};
+    page.pixels = (uint8_t *)calloc(GLYPH_PAGE_SIZE * GLYPH_PAGE_SIZE, 1);
+    page.texture = LoadTextureFromPixels(GLYPH_PAGE_SIZE, GLYPH_PAGE_SIZE, page.pixels, TextureFormatR8);
+    page.cellClass = cellClass;
+
+    page.dirtyMinX = GLYPH_PAGE_SIZE;
+    page.dirtyMinY = GLYPH_PAGE_SIZE;
+
+    uint32_t pageIndex = (uint32_t)pages.size();
+    pages.push_back(page);
+
+    uint32_t cellSize = GLYPH_MIN_CELL << cellClass;
+    uint32_t columns = GLYPH_PAGE_SIZE / cellSize;
+
+    for (uint32_t i = 0; i < columns * columns; ++i)
+    {
+        GlyphCell cell = {};
+        cell.page = pageIndex;
+        cell.x = (uint16_t)(i % columns * cellSize);
+        cell.y = (uint16_t)(i / columns * cellSize);
+
+        cells.push_back(cell);
+        LinkCellBack((uint32_t)cells.size() - 1);
+    }
+
+    return true;
+}
+
+static uint64_t GetGlyphKey(_Font *font, uint32_t glyph, uint32_t pixelSize)
+{
+    return (uint64_t)font->id << 32 | (uint64_t)pixelSize << 16 | glyph;
+}
+
+const GlyphCell *GetGlyphCell(_Font *font, uint32_t glyph, uint32_t pixelSize)
+{
+    uint64_t key = GetGlyphKey(font, glyph, pixelSize);
+
+    auto it = glyphLookup.find(key);
+    if (it != glyphLookup.end())
+    {
+        uint32_t index = it->second;
+
+        UnlinkCell(index);
+        LinkCellFront(index);
+
+        cells[index].lastUsedFrame = renderer.frameCounter;
+        return &cells[index];
+    }
+
+    float scale = (float)pixelSize / (float)font->ttf.unitsPerEm;
+
+    // Pixel bounds with y down, relative to the pen position on the baseline
+    int32_t left, top, right, bottom;
+    GetGlyphBitmapBox(&font->ttf, glyph, scale, &left, &top, &right, &bottom);
+
+    if (right <= left || bottom <= top)
+        return nullptr;
+
+    uint32_t width = (uint32_t)(right - left);
+    uint32_t height = (uint32_t)(bottom - top);
+    uint32_t needed = (width > height ? width : height) + GLYPH_PADDING * 2;
+
+    uint32_t cellClass = 0;
+    while (cellClass < GLYPH_CELL_CLASSES && ((uint32_t)GLYPH_MIN_CELL << cellClass) < needed)
+    {
+        ++cellClass;
+    }
+
+    if (cellClass == GLYPH_CELL_CLASSES)
+        return nullptr;
+
+    uint32_t tail = cellClasses[cellClass].tail;
+    if (tail == GLYPH_NONE || (cells[tail].key != 0 && cells[tail].lastUsedFrame == renderer.frameCounter))
+    {
+        if (!AddGlyphPage(cellClass))
+        {
+            static bool warned = false;
+            if (!warned)
+                printf("Glyph atlas is full, glyphs are skipped until older ones can be evicted\n");
+
+            warned = true;
+            return nullptr;
+        }
+
+        tail = cellClasses[cellClass].tail;
+    }
+
+    GlyphCell &cell = cells[tail];
+    if (cell.key != 0)
+        glyphLookup.erase(cell.key);
+
+    cell.key = key;
+    cell.lastUsedFrame = renderer.frameCounter;
+    cell.width = (uint16_t)width;
+    cell.height = (uint16_t)height;
+    cell.left = (int16_t)left;
+    cell.top = (int16_t)top;
+
+    UnlinkCell(tail);
+    LinkCellFront(tail);
+
+    glyphLookup[key] = tail;
+
+    // The whole cell is rewritten, so nothing of the evicted glyph is left in the padding
+    GlyphPage &page = pages[cell.page];
+    uint32_t cellSize = GLYPH_MIN_CELL << cellClass;
+
+    for (uint32_t row = 0; row < cellSize; ++row)
+    {
+        memset(page.pixels + (cell.y + row) * GLYPH_PAGE_SIZE + cell.x, 0, cellSize);
+    }
+
+    uint8_t *pixels = page.pixels + (cell.y + GLYPH_PADDING) * GLYPH_PAGE_SIZE + cell.x + GLYPH_PADDING;
+    RasterizeGlyph(&font->ttf, glyph, scale, pixels, width, height, GLYPH_PAGE_SIZE);
+
+    page.dirtyMinX = page.dirtyMinX < cell.x ? page.dirtyMinX : cell.x;
+    page.dirtyMinY = page.dirtyMinY < cell.y ? page.dirtyMinY : cell.y;
+    page.dirtyMaxX = page.dirtyMaxX > cell.x + cellSize ? page.dirtyMaxX : cell.x + cellSize;
+    page.dirtyMaxY = page.dirtyMaxY > cell.y + cellSize ? page.dirtyMaxY : cell.y + cellSize;
+
+    return &cell;
+}
+
+Texture *GetGlyphPageTexture(uint32_t page)
+{
+    return pages[page].texture;
+}
+
+static bool AddMsdfPage()
+{
+    if (msdfPages.size() >= MSDF_MAX_PAGES)
+        return false;
+
+    MsdfPage page = {};
+    page.pixels = (uint8_t *)calloc(MSDF_PAGE_SIZE * MSDF_PAGE_SIZE, 4);
+    page.texture = LoadTextureFromPixels(MSDF_PAGE_SIZE, MSDF_PAGE_SIZE, page.pixels, TextureFormatRGBA8Linear);
+
+    page.dirtyMinX = MSDF_PAGE_SIZE;
+    page.dirtyMinY = MSDF_PAGE_SIZE;
+
+    msdfPages.push_back(page);
+    return true;
+}
+
+// Glyphs are one texel apart, the cleared gap reads as far outside when filtering reaches it
+static bool PackMsdfGlyph(MsdfGlyph *glyph)
+{
+    uint32_t width = glyph->width + 1u;
+    uint32_t height = glyph->height + 1u;
+
+    if (width > MSDF_PAGE_SIZE || height > MSDF_PAGE_SIZE)
+        return false;
+
+    if (msdfPages.empty() && !AddMsdfPage())
+        return false;
+
+    MsdfPage *page = &msdfPages.back();
+
+    if (page->shelfX + width > MSDF_PAGE_SIZE)
+    {
+        page->shelfX = 0;
+        page->shelfY += page->shelfHeight;
+        page->shelfHeight = 0;
+    }
+
+    if (page->shelfY + height > MSDF_PAGE_SIZE)
+    {
+        if (!AddMsdfPage())
+            return false;
+
+        page = &msdfPages.back();
+    }
+
+    glyph->page = (uint32_t)msdfPages.size() - 1;
+    glyph->x = (uint16_t)page->shelfX;
+    glyph->y = (uint16_t)page->shelfY;
+
+    page->shelfX += width;
+    page->shelfHeight = page->shelfHeight > height ? page->shelfHeight : height;
+
+    page->dirtyMinX = page->dirtyMinX < glyph->x ? page->dirtyMinX : glyph->x;
+    page->dirtyMinY = page->dirtyMinY < glyph->y ? page->dirtyMinY : glyph->y;
+    page->dirtyMaxX = page->dirtyMaxX > glyph->x + glyph->width ? page->dirtyMaxX : glyph->x + glyph->width;
+    page->dirtyMaxY = page->dirtyMaxY > glyph->y + glyph->height ? page->dirtyMaxY : glyph->y + glyph->height;
+
+    return true;
+}
+
+struct MsdfJob
+{
+    uint32_t glyph;
+    GlyphOutline outline;
+    MsdfGlyph placed;
+};
+
+static std::vector<MsdfJob> msdfJobs;
+
+void PrepareMsdfGlyphs(_Font *font, const TextLayout &layout)
+{
+    float scale = (float)MSDF_EM_SIZE / (float)font->ttf.unitsPerEm;
+
+    // Outlines are read and placed here, only the fields are generated on the workers
+    uint32_t jobCount = 0;
+    for (const PlacedGlyph &placed : layout.glyphs)
+    {
+        uint64_t key = (uint64_t)font->id << 32 | placed.glyph;
+        if (msdfLookup.count(key))
+            continue;
+
+        if (jobCount == msdfJobs.size())
+            msdfJobs.emplace_back();
+
+        MsdfJob &job = msdfJobs[jobCount];
+        if (!GetGlyphOutline(&font->ttf, placed.glyph, &job.outline))
+            continue;
+
+        int32_t left = (int32_t)floorf(job.outline.min.x * scale) - MSDF_RANGE;
+        int32_t right = (int32_t)ceilf(job.outline.max.x * scale) + MSDF_RANGE;
+        int32_t top = (int32_t)floorf(-job.outline.max.y * scale) - MSDF_RANGE;
+        int32_t bottom = (int32_t)ceilf(-job.outline.min.y * scale) + MSDF_RANGE;
+
+        job.glyph = placed.glyph;
+        job.placed.width = (uint16_t)(right - left);
+        job.placed.height = (uint16_t)(bottom - top);
+        job.placed.left = (int16_t)left;
+        job.placed.top = (int16_t)top;
+
+        if (!PackMsdfGlyph(&job.placed))
+        {
+            static bool warned = false;
+            if (!warned)
+                printf("Distance field glyph atlas is full, new glyphs are skipped\n");
+
+            warned = true;
+            break;
+        }
+
+        // Repeated glyphs of the layout find this entry, the field is written before anything samples it
+        msdfLookup[key] = (uint32_t)msdfGlyphs.size();
+        msdfGlyphs.push_back(job.placed);
+
+        ++jobCount;
+    }
+
+    if (jobCount == 0)
+        return;
+
+    ParallelFor(jobCount, 1, [scale](uint32_t begin, uint32_t end)
+    {
+        for (uint32_t i = begin; i < end; ++i)
+        {
+            const MsdfJob &job = msdfJobs[i];
+            MsdfPage &page = msdfPages[job.placed.page];
+
+            uint8_t *pixels = page.pixels + (job.placed.y * MSDF_PAGE_SIZE + job.placed.x) * 4;
+            GenerateMsdf(job.outline, scale, glm::vec2(-job.placed.left, -job.placed.top), (float)MSDF_RANGE, pixels, job.placed.width, job.placed.height, MSDF_PAGE_SIZE * 4);
+        }
+    });
+}
+
+const MsdfGlyph *GetMsdfGlyph(_Font *font, uint32_t glyph)
+{
+    auto it = msdfLookup.find((uint64_t)font->id << 32 | glyph);
+    if (it == msdfLookup.end())
+        return nullptr;
+
+    return &msdfGlyphs[it->second];
+}
+
+Texture *GetMsdfPageTexture(uint32_t page)
+{
+    return msdfPages[page].texture;
+}
+
+void FlushGlyphUploads()
+{
+    for (GlyphPage &page : pages)
+    {
+        if (page.dirtyMaxX <= page.dirtyMinX || page.dirtyMaxY <= page.dirtyMinY)
+            continue;
+
+        const uint8_t *pixels = page.pixels + page.dirtyMinY * GLYPH_PAGE_SIZE + page.dirtyMinX;
+        UpdateTextureRegion(page.texture, page.dirtyMinX, page.dirtyMinY, page.dirtyMaxX - page.dirtyMinX, page.dirtyMaxY - page.dirtyMinY, pixels, GLYPH_PAGE_SIZE);
+
+        page.dirtyMinX = GLYPH_PAGE_SIZE;
+        page.dirtyMinY = GLYPH_PAGE_SIZE;
+        page.dirtyMaxX = 0;
+        page.dirtyMaxY = 0;
+    }
+
+    for (MsdfPage &page : msdfPages)
+    {
+        if (page.dirtyMaxX <= page.dirtyMinX || page.dirtyMaxY <= page.dirtyMinY)
+            continue;
+
+        const uint8_t *pixels = page.pixels + (page.dirtyMinY * MSDF_PAGE_SIZE + page.dirtyMinX) * 4;
+        UpdateTextureRegion(page.texture, page.dirtyMinX, page.dirtyMinY, page.dirtyMaxX - page.dirtyMinX, page.dirtyMaxY - page.dirtyMinY, pixels, MSDF_PAGE_SIZE * 4);
+
+        page.dirtyMinX = MSDF_PAGE_SIZE;
+        page.dirtyMinY = MSDF_PAGE_SIZE;
+        page.dirtyMaxX = 0;
+        page.dirtyMaxY = 0;
+    }
+}
+
+void ShutdownFonts()
+{
+    for (GlyphPage &page : pages)
+    {
+        DestroyTexture(page.texture);
+        free(page.pixels);
+    }
+
+    for (MsdfPage &page : msdfPages)
+    {
+        DestroyTexture(page.texture);
+        free(page.pixels);
+    }
+
+    pages.clear();
+    cells.clear();
+    glyphLookup.clear();
+
+    msdfPages.clear();
+    msdfGlyphs.clear();
+    msdfLookup.clear();
+    msdfJobs.clear();
+
+    for (GlyphCellClass &cellClass : cellClasses)
+    {
+        cellClass = GlyphCellClass();
+    }
+}
\ No newline at end of file
@@ -0,0 +1,144 @@
+#pragma once
+
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+#include <glm/glm.hpp>
+
+#include "Internal.h"
+#include "TrueType.h"
+
+// Glyph bitmaps live in R8 atlas pages, each split into square cells of one size. A glyph takes the
+// smallest cell class it fits with GLYPH_PADDING empty pixels around it, so filtering never reaches a
+// neighbour. Classes are GLYPH_MIN_CELL doubled up to GLYPH_CELL_CLASSES times.
+#define GLYPH_PAGE_SIZE 1024
+#define GLYPH_MIN_CELL 16
+#define GLYPH_CELL_CLASSES 5
+#define GLYPH_PADDING 1
+#define GLYPH_MAX_PAGES 16
+
+// Larger text is drawn from magnified bitmaps of this size, so even tall glyphs fit the largest cell
+#define GLYPH_MAX_PIXEL_SIZE 192
+
+// Layouts not used in the current frame are dropped once a font caches this many
+#define TEXT_LAYOUT_CACHE_SIZE 1024
+
+#define GLYPH_NONE UINT32_MAX
+
+// Distance field glyphs are generated once at MSDF_EM_SIZE texels per em and scaled to any size in the
+// shader, see res/shaders/shape.frag. Each keeps MSDF_RANGE texels of field around its outline, which
+// also bounds how far outlines and shadows reach. They are packed on shelves of RGBA8 pages and kept
+// until ShutdownFonts.
+#define MSDF_PAGE_SIZE 1024
+#define MSDF_EM_SIZE 32
+#define MSDF_RANGE 4
+#define MSDF_MAX_PAGES 8
+
+// Cells of a class are linked in least recently used order. Glyphs drawn in the current frame are
+// never evicted, their pixels may still be uploaded and sampled this frame.
+struct GlyphCell
+{
+    uint64_t key;           // 0 while free
+    uint64_t lastUsedFrame;
+
+    uint32_t page;
+    uint16_t x, y;
+
+    // Bitmap size and its offset from the pen position on the baseline
+    uint16_t width, height;
+    int16_t left, top;
+
+    uint32_t previous, next;
+};
+
+struct GlyphPage
+{
+    Texture *texture;
+    uint8_t *pixels;        // CPU copy, changed rectangles are uploaded once per frame
+    uint32_t cellClass;
+
+    uint32_t dirtyMinX, dirtyMinY;
+    uint32_t dirtyMaxX, dirtyMaxY;      // Nothing to upload while max <= min
+};
+
+struct MsdfGlyph
+{
+    uint32_t page;
+    uint16_t x, y;
+
+    // Field size including the range on every side, and its offset from the pen position on the
+    // baseline, in texels
+    uint16_t width, height;
+    int16_t left, top;
+};
+
+// Glyphs are placed left to right on the current shelf, a glyph that doesn't fit starts a new one
+struct MsdfPage
+{
+    Texture *texture;
+    uint8_t *pixels;
+
+    uint32_t shelfX, shelfY, shelfHeight;
+
+    uint32_t dirtyMinX, dirtyMinY;
+    uint32_t dirtyMaxX, dirtyMaxY;
+};
+
+struct GlyphCellClass
+{
+    uint32_t head = GLYPH_NONE;     // Most recently used
+    uint32_t tail = GLYPH_NONE;
+};
+
+// Pen position of each visible glyph relative to the top left of the text, in pixels
+struct PlacedGlyph
+{
+    uint32_t glyph;
+    glm::vec2 pen;
+};
+
+struct TextLayout
+{
+    std::string text;       // Compared on lookup, the key is only a hash
+    uint32_t pixelSize;     // 0 for layouts in ems
+
+    std::vector<PlacedGlyph> glyphs;
+    glm::vec2 extent;
+
+    uint64_t lastUsedFrame;
+};
+
+struct _Font
+{
+    MappedFile file;
+    TrueTypeFont ttf;
+
+    uint32_t id;            // Part of every atlas key, never reused
+
+    // Keyed by hash of the pixel size and text
+    std::unordered_map<uint64_t, TextLayout> layouts;
+};
+
+// Whole pixels, from 1 to GLYPH_MAX_PIXEL_SIZE
+uint32_t GetFontPixelSize(float size);
+
+// A pixelSize of 0 lays the text out in ems without rounding to pixels, for text that is scaled freely
+const TextLayout &GetTextLayout(_Font *font, const char *text, uint32_t pixelSize);
+
+// Rasterizes the glyph on first use. Returns null for glyphs without pixels or when every cell of
+// the class was used this frame and no page is left. The pointer is only valid until the next call.
+const GlyphCell *GetGlyphCell(_Font *font, uint32_t glyph, uint32_t pixelSize);
+Texture *GetGlyphPageTexture(uint32_t page);
+
+// Generates the distance fields of the layout's glyphs that aren't in the atlas yet, spread over the
+// job workers. Afterwards GetMsdfGlyph returns null only for glyphs that didn't fit in the atlas.
+void PrepareMsdfGlyphs(_Font *font, const TextLayout &layout);
+const MsdfGlyph *GetMsdfGlyph(_Font *font, uint32_t glyph);
+Texture *GetMsdfPageTexture(uint32_t page);
+
+// Records the upload of this frame's new glyphs, before the upload command buffer is submitted
+void FlushGlyphUploads();
+void ShutdownFonts();
\ No newline at end of file
@@ -0,0 +1,204 @@
+#include "GlslCompiler.h"
+
+#include "Hash.h"
+
+#include <glslang/Public/ShaderLang.h>
+#include <SPIRV/GlslangToSpv.h>
+#include <StandAlone/DirStackFileIncluder.h>
+
+static const TBuiltInResource DefaultTBuiltInResource = {
+    /* .MaxLights = */ 32,
+    /* .MaxClipPlanes = */ 6,
+    /* .MaxTextureUnits = */ 32,
+    /* .MaxTextureCoords = */ 32,
+    /* .MaxVertexAttribs = */ 64,
+    /* .MaxVertexUniformComponents = */ 4096,
+    /* .MaxVaryingFloats = */ 64,
+    /* .MaxVertexTextureImageUnits = */ 32,
+    /* .MaxCombinedTextureImageUnits = */ 80,
+    /* .MaxTextureImageUnits = */ 32,
+    /* .MaxFragmentUniformComponents = */ 4096,
+    /* .MaxDrawBuffers = */ 32,
+    /* .MaxVertexUniformVectors = */ 128,
+    /* .MaxVaryingVectors = */ 8,
+    /* .MaxFragmentUniformVectors = */ 16,
+    /* .MaxVertexOutputVectors = */ 16,
+    /* .MaxFragmentInputVectors = */ 15,
+    /* .MinProgramTexelOffset = */ -8,
+    /* .MaxProgramTexelOffset = */ 7,
+    /* .MaxClipDistances = */ 8,
+    /* .MaxComputeWorkGroupCountX = */ 65535,
+    /* .MaxComputeWorkGroupCountY = */ 65535,
+    /* .MaxComputeWorkGroupCountZ = */ 65535,
+    /* .MaxComputeWorkGroupSizeX = */ 1024,
+    /* .MaxComputeWorkGroupSizeY = */ 1024,
+    /* .MaxComputeWorkGroupSizeZ = */ 64,
+    /* .MaxComputeUniformComponents = */ 1024,
+    /* .MaxComputeTextureImageUnits = */ 16,
+    /* .MaxComputeImageUniforms = */ 8,
+    /* .MaxComputeAtomicCounters = */ 8,
+    /* .MaxComputeAtomicCounterBuffers = */ 1,
+    /* .MaxVaryingComponents = */ 60,
+    /* .MaxVertexOutputComponents = */ 64,
+    /* .MaxGeometryInputComponents = */ 64,
+    /* .MaxGeometryOutputComponents = */ 128,
+    /* .MaxFragmentInputComponents = */ 128,
+    /* .MaxImageUnits = */ 8,
+    /* .MaxCombinedImageUnitsAndFragmentOutputs = */ 8,
+    /* .MaxCombinedShaderOutputResources = */ 8,
+    /* .MaxImageSamples = */ 0,
+    /* .MaxVertexImageUniforms = */ 0,
+    /* .MaxTessControlImageUniforms = */ 0,
+    /* .MaxTessEvaluationImageUniforms = */ 0,
+    /* .MaxGeometryImageUniforms = */ 0,
+    /* .MaxFragmentImageUniforms = */ 8,
+    /* .MaxCombinedImageUniforms = */ 8,
+    /* .MaxGeometryTextureImageUnits = */ 16,
+    /* .MaxGeometryOutputVertices = */ 256,
+    /* .MaxGeometryTotalOutputComponents = */ 1024,
+    /* .MaxGeometryUniformComponents = */ 1024,
+    /* .MaxGeometryVaryingComponents = */ 64,
+    /* .MaxTessControlInputComponents = */ 128,
+    /* .MaxTessControlOutputComponents = */ 128,
+    /* .MaxTessControlTextureImageUnits = */ 16,
+    /* .MaxTessControlUniformComponents = */ 1024,
+    /* .MaxTessControlTotalOutputComponents = */ 4096,
+    /* .MaxTessEvaluationInputComponents = */ 128,
+    /* .MaxTessEvaluationOutputComponents = */ 128,
+    /* .MaxTessEvaluationTextureImageUnits = */ 16,
+    /* .MaxTessEvaluationUniformComponents = */ 1024,
+    /* .MaxTessPatchComponents = */ 120,
+    /* .MaxPatchVertices = */ 32,
+    /* .MaxTessGenLevel = */ 64,
+    /* .MaxViewports = */ 16,
+    /* .MaxVertexAtomicCounters = */ 0,
+    /* .MaxTessControlAtomicCounters = */ 0,
+    /* .MaxTessEvaluationAtomicCounters = */ 0,
+    /* .MaxGeometryAtomicCounters = */ 0,
+    /* .MaxFragmentAtomicCounters = */ 8,
+    /* .MaxCombinedAtomicCounters = */ 8,
+    /* .MaxAtomicCounterBindings = */ 1,
+    /* .MaxVertexAtomicCounterBuffers = */ 0,
+    /* .MaxTessControlAtomicCounterBuffers = */ 0,
+    /* .MaxTessEvaluationAtomicCounterBuffers = */ 0,
+    /* .MaxGeometryAtomicCounterBuffers = */ 0,
+    /* .MaxFragmentAtomicCounterBuffers = */ 1,
+    /* .MaxCombinedAtomicCounterBuffers = */ 1,
+    /* .MaxAtomicCounterBufferSize = */ 16384,
+    /* .MaxTransformFeedbackBuffers = */ 4,
+    /* .MaxTransformFeedbackInterleavedComponents = */ 64,
+    /* .MaxCullDistances = */ 8,
+    /* .MaxCombinedClipAndCullDistances = */ 8,
+    /* .MaxSamples = */ 4,
+    /* .maxMeshOutputVerticesNV = */ 256,
+    /* .maxMeshOutputPrimitivesNV = */ 512,
+    /* .maxMeshWorkGroupSizeX_NV = */ 32,
+    /* .maxMeshWorkGroupSizeY_NV = */ 1,
+    /* .maxMeshWorkGroupSizeZ_NV = */ 1,
+    /* .maxTaskWorkGroupSizeX_NV = */ 32,
+    /* .maxTaskWorkGroupSizeY_NV = */ 1,
+    /* .maxTaskWorkGroupSizeZ_NV = */ 1,
+    /* .maxMeshViewCountNV = */ 4,
+    /* .maxDualSourceDrawBuffersEXT = */ 1,
+
+    /* .limits = */ {
+        /* .nonInductiveForLoops = */ 1,
+        /* .whileLoops = */ 1,
+        /* .doWhileLoops = */ 1,
+        /* .generalUniformIndexing = */ 1,
+        /* .generalAttributeMatrixVectorIndexing = */ 1,
+        /* .generalVaryingIndexing = */ 1,
+        /* .generalSamplerIndexing = */ 1,
+        /* .generalVariableIndexing = */ 1,
+        /* .generalConstantMatrixVectorIndexing = */ 1,
+    }
+};
+
+static std::string GetSuffix(const std::string &path)
+{
+    const size_t pos = path.rfind('.');
+    return (pos == std::string::npos) ? "" : path.substr(pos + 1);
+}
+
+static EShLanguage GetShaderStage(const std::string &stage)
+{
+    if (stage == "vert")
+        return EShLangVertex;
+    else if (stage == "frag")
+        return EShLangFragment;
+    else
+        return EShLangCount;
+}
+
+// Records every include glslang resolves, so cached output can be invalidated when one changes
+class RecordingIncluder : public DirStackFileIncluder
+{
+public:
+    std::vector<ShaderInclude> includes;
+
+    IncludeResult *includeLocal(const char *headerName, const char *includerName, size_t inclusionDepth) override
+    {
+        IncludeResult *result = DirStackFileIncluder::includeLocal(headerName, includerName, inclusionDepth);
+        if (result)
+            includes.push_back({ result->headerName, HashMemory(result->headerData, result->headerLength) });
+
+        return result;
+    }
+};
+
+bool CompileGlslToSpirv(const std::string &path, const std::string &source, const std::string &preamble, bool validate, std::vector<uint32_t> *spirv, std::vector<ShaderInclude> *includes, std::string *log)
+{
+    EShLanguage shaderType = GetShaderStage(GetSuffix(path));
+    if (shaderType == EShLangCount)
+    {
+        *log = "Unknown shader stage: " + path;
+        return false;
+    }
+
+    const char *inputcstr = source.c_str();
+
+    glslang::TShader shader(shaderType);
+    shader.setStrings(&inputcstr, 1);
+    shader.setPreamble(preamble.c_str());
+
+    shader.setEnvInput(glslang::EShSourceGlsl, shaderType, glslang::EShClientVulkan, 120);
+    shader.setEnvClient(glslang::EShClientVulkan, glslang::EShTargetVulkan_1_2);
+    shader.setEnvTarget(glslang::EshTargetSpv, glslang::EShTargetSpv_1_5);
+
+    EShMessages messages = (EShMessages) (EShMsgSpvRules | EShMsgVulkanRules);
+
+    size_t found = path.find_last_of("/\\");
+    std::string noFilePath = found == std::string::npos ? "." : path.substr(0, found);
+
+    RecordingIncluder includer;
+    includer.pushExternalLocalDirectory(noFilePath);
+
+    TBuiltInResource resources = DefaultTBuiltInResource;
+
+    if (!shader.parse(&resources, 120, false, messages, includer))
+    {
+        *log = "Failed to parse " + path + "\n" + shader.getInfoLog() + shader.getInfoDebugLog();
+        return false;
+    }
+
+    glslang::TProgram program;
+    program.addShader(&shader);
+
+    if (!program.link(messages))
+    {
+        *log = "Failed to link " + path + "\n" + program.getInfoLog() + program.getInfoDebugLog();
+        return false;
+    }
+
+    spv::SpvBuildLogger logger;
+    glslang::SpvOptions options;
+    options.validate = validate;
+
+    spirv->clear();
+    glslang::GlslangToSpv(*program.getIntermediate(shaderType), *spirv, &logger, &options);
+
+    *includes = std::move(includer.includes);
+    *log = logger.getAllMessages();
+
+    return true;
+}
\ No newline at end of file
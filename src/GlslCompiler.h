@@ -0,0 +1,18 @@
+#pragma once
+
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+struct ShaderInclude
+{
+    std::string path;
+    uint64_t hash;
+};
+
+// Shared by the runtime and vk2d-shaderc. glslang::InitializeProcess must have been called. The
+// stage comes from the extension (.vert or .frag), includes resolve relative to path. The preamble
+// is inserted after #version, meant for #define lines. On failure log holds the compiler output
+// and the old SPIR-V, if any, should be kept.
+bool CompileGlslToSpirv(const std::string &path, const std::string &source, const std::string &preamble, bool validate, std::vector<uint32_t> *spirv, std::vector<ShaderInclude> *includes, std::string *log);
\ No newline at end of file
@@ -2,10 +2,148 @@
 
 #include "Internal.h"
 #include "Utils.h"
+#include "JobSystem.h"
+#include "LayoutCache.h"
 
-void CreateGraphicsPipeline(GraphicsPipeline *pipeline, Shader *shader, VkPrimitiveTopology topology)
+#include <mutex>
+
+// Guards variant maps against the hot reload thread, which lists their keys. Only the render thread
+// inserts into the maps of live pipelines, so its lookups go without the lock.
+static std::mutex variantMutex;
+
+static PipelineKey NormalizePipelineKey(GraphicsPipeline *pipeline, const PipelineKey &key)
+{
+    PipelineKey normalized = key;
+    normalized.specialization &= pipeline->shader.specConstantMask;
+
+    // State that is set on the command buffer doesn't need a pipeline of its own
+    if (renderer.dynamicTopology)
+        normalized.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+    if (renderer.dynamicBlend)
+        normalized.blendMode = BlendModeAlpha;
+
+    return normalized;
+}
+
+static VkRenderPass GetCompatibleRenderPass(VkFormat format)
+{
+    if (format == renderer.swapchain.imageFormat)
+        return renderer.renderPass;
+
+    return GetTargetRenderPass(format);
+}
+
+static VkPipelineColorBlendAttachmentState GetBlendAttachment(BlendMode mode)
+{
+    VkPipelineColorBlendAttachmentState attachment = {};
+    attachment.blendEnable = VK_TRUE;
+    attachment.colorBlendOp = VK_BLEND_OP_ADD;
+    attachment.alphaBlendOp = VK_BLEND_OP_ADD;
+    attachment.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
+
+    switch (mode)
+    {
+        case BlendModeAlpha:
+            attachment.srcColorBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA;
+            attachment.dstColorBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+            attachment.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
+            attachment.dstAlphaBlendFactor = VK_BLEND_FACTOR_ZERO;
+            break;
+
+        case BlendModeAdditive:
+            attachment.srcColorBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA;
+            attachment.dstColorBlendFactor = VK_BLEND_FACTOR_ONE;
+            attachment.srcAlphaBlendFactor = VK_BLEND_FACTOR_ZERO;
+            attachment.dstAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
+            break;
+
+        case BlendModeMultiply:
+            attachment.srcColorBlendFactor = VK_BLEND_FACTOR_DST_COLOR;
+            attachment.dstColorBlendFactor = VK_BLEND_FACTOR_ZERO;
+            attachment.srcAlphaBlendFactor = VK_BLEND_FACTOR_ZERO;
+            attachment.dstAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
+            break;
+
+        case BlendModePremultiplied:
+            attachment.srcColorBlendFactor = VK_BLEND_FACTOR_ONE;
+            attachment.dstColorBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+            attachment.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
+            attachment.dstAlphaBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+            break;
+
+        case BlendModeOpaque:
+            attachment.blendEnable = VK_FALSE;
+            attachment.srcColorBlendFactor = VK_BLEND_FACTOR_ONE;
+            attachment.dstColorBlendFactor = VK_BLEND_FACTOR_ZERO;
+            attachment.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
+            attachment.dstAlphaBlendFactor = VK_BLEND_FACTOR_ZERO;
+            break;
+    }
+
+    return attachment;
+}
+
+void CmdSetBlendMode(VkCommandBuffer commandBuffer, BlendMode mode)
 {
-    VkPipelineVertexInputStateCreateInfo vertexInputStage = {};
+    VkPipelineColorBlendAttachmentState attachment = GetBlendAttachment(mode);
+
+    VkColorBlendEquationEXT equation = {};
+    equation.srcColorBlendFactor = attachment.srcColorBlendFactor;
+    equation.dstColorBlendFactor = attachment.dstColorBlendFactor;
+    equation.colorBlendOp = attachment.colorBlendOp;
+    equation.srcAlphaBlendFactor = attachment.srcAlphaBlendFactor;
+    equation.dstAlphaBlendFactor = attachment.dstAlphaBlendFactor;
+    equation.alphaBlendOp = attachment.alphaBlendOp;
+
+    vkCmdSetColorBlendEnableEXT(commandBuffer, 0, 1, &attachment.blendEnable);
+    vkCmdSetColorBlendEquationEXT(commandBuffer, 0, 1, &equation);
+}
+
+void CreateGraphicsPipeline(GraphicsPipeline *pipeline, Shader *shader)
+{
+    pipeline->shader = *shader;
+    pipeline->variants.clear();
+
+    pipeline->setLayouts.resize(shader->sets.size());
+
+    for (uint32_t i = 0; i < (uint32_t)shader->sets.size(); ++i)
+    {
+        pipeline->setLayouts[i] = GetDescriptorSetLayout(shader->sets[i]);
+    }
+
+    pipeline->layout = GetPipelineLayout(pipeline->setLayouts, shader->ranges);
+}
+
+// Every create info a variant needs, kept together so a batch can be built up front and
+// handed to worker threads
+struct PipelineState
+{
+    VkPipelineVertexInputStateCreateInfo vertexInputStage;
+    VkPipelineInputAssemblyStateCreateInfo inputAssemblyState;
+    VkPipelineViewportStateCreateInfo viewportState;
+    VkPipelineRasterizationStateCreateInfo rasterizationState;
+    VkPipelineMultisampleStateCreateInfo multisampleState;
+    VkPipelineColorBlendAttachmentState attachment;
+    VkPipelineColorBlendStateCreateInfo colorBlendState;
+    VkDynamicState states[6];
+    VkPipelineDynamicStateCreateInfo dynamicState;
+
+    std::vector<VkPipelineShaderStageCreateInfo> stages;
+    VkSpecializationMapEntry entries[32];
+    VkBool32 values[32];
+    VkSpecializationInfo specialization;
+
+    VkGraphicsPipelineCreateInfo pipelineInfo;
+};
+
+// Not thread safe, it may create the render pass
+static void InitPipelineState(PipelineState *state, GraphicsPipeline *pipeline, const PipelineKey &key)
+{
+    Shader *shader = &pipeline->shader;
+
+    *state = {};
+
+    VkPipelineVertexInputStateCreateInfo &vertexInputStage = state->vertexInputStage;
     vertexInputStage.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
     vertexInputStage.pNext = nullptr;
     vertexInputStage.flags = 0;
@@ -14,13 +152,13 @@ void CreateGraphicsPipeline(GraphicsPipeline *pipeline, Shader *shader, VkPrimit
     vertexInputStage.vertexBindingDescriptionCount = 1;
     vertexInputStage.pVertexBindingDescriptions = &shader->binding;
 
-    VkPipelineInputAssemblyStateCreateInfo inputAssemblyState = {};
+    VkPipelineInputAssemblyStateCreateInfo &inputAssemblyState = state->inputAssemblyState;
     inputAssemblyState.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
     inputAssemblyState.flags = 0;
-    inputAssemblyState.topology = topology;
+    inputAssemblyState.topology = key.topology;
     inputAssemblyState.primitiveRestartEnable = VK_FALSE;
 
-    VkPipelineViewportStateCreateInfo viewportState = {};
+    VkPipelineViewportStateCreateInfo &viewportState = state->viewportState;
     viewportState.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
     viewportState.pNext = nullptr;
     viewportState.flags = 0;
@@ -29,14 +167,15 @@ void CreateGraphicsPipeline(GraphicsPipeline *pipeline, Shader *shader, VkPrimit
     viewportState.scissorCount = 1;
     viewportState.pScissors = nullptr;
 
-    VkPipelineRasterizationStateCreateInfo rasterizationState = {};
+    // Sprites are flipped with negative scales, so winding can't be relied on to cull anything
+    VkPipelineRasterizationStateCreateInfo &rasterizationState = state->rasterizationState;
     rasterizationState.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
     rasterizationState.pNext = nullptr;
     rasterizationState.flags = 0;
     rasterizationState.depthClampEnable = VK_FALSE;
     rasterizationState.rasterizerDiscardEnable = VK_FALSE;
     rasterizationState.polygonMode = VK_POLYGON_MODE_FILL;
-    rasterizationState.cullMode = VK_CULL_MODE_BACK_BIT;
+    rasterizationState.cullMode = VK_CULL_MODE_NONE;
     rasterizationState.frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE;
     rasterizationState.depthBiasEnable = VK_FALSE;
     rasterizationState.depthBiasConstantFactor = 0.0f;
@@ -44,109 +183,228 @@ void CreateGraphicsPipeline(GraphicsPipeline *pipeline, Shader *shader, VkPrimit
     rasterizationState.depthBiasSlopeFactor = 0.0f;
     rasterizationState.lineWidth = 1.0f;
 
-    VkPipelineMultisampleStateCreateInfo multisampleState = {};
+    VkPipelineMultisampleStateCreateInfo &multisampleState = state->multisampleState;
     multisampleState.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
     multisampleState.pNext = nullptr;
     multisampleState.flags = 0;
-    multisampleState.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+    multisampleState.rasterizationSamples = key.samples;
     multisampleState.sampleShadingEnable = VK_FALSE;
     multisampleState.minSampleShading = 0.0f;
     multisampleState.pSampleMask = nullptr;
     multisampleState.alphaToCoverageEnable = VK_FALSE;
     multisampleState.alphaToOneEnable = VK_FALSE;
 
-    VkPipelineColorBlendAttachmentState attachment = {};
-    attachment.blendEnable = VK_TRUE;
-    attachment.srcColorBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA;
-    attachment.dstColorBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
-    attachment.colorBlendOp = VK_BLEND_OP_ADD;
-    attachment.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
-    attachment.dstAlphaBlendFactor = VK_BLEND_FACTOR_ZERO;
-    attachment.alphaBlendOp = VK_BLEND_OP_ADD;
-    attachment.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
+    state->attachment = GetBlendAttachment(key.blendMode);
 
-    VkPipelineColorBlendStateCreateInfo colorBlendState = {};
+    VkPipelineColorBlendStateCreateInfo &colorBlendState = state->colorBlendState;
     colorBlendState.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
     colorBlendState.pNext = nullptr;
     colorBlendState.flags = 0;
     colorBlendState.logicOpEnable = VK_FALSE;
     colorBlendState.logicOp = VK_LOGIC_OP_COPY;
     colorBlendState.attachmentCount = 1;
-    colorBlendState.pAttachments = &attachment;
+    colorBlendState.pAttachments = &state->attachment;
     colorBlendState.blendConstants[0] = 0.0f;
     colorBlendState.blendConstants[1] = 0.0f;
     colorBlendState.blendConstants[2] = 0.0f;
     colorBlendState.blendConstants[3] = 0.0f;
 
-    std::vector<VkDynamicState> states = {
-        VK_DYNAMIC_STATE_VIEWPORT,
-        VK_DYNAMIC_STATE_SCISSOR
-    };
+    uint32_t stateCount = 0;
+    state->states[stateCount++] = VK_DYNAMIC_STATE_VIEWPORT;
+    state->states[stateCount++] = VK_DYNAMIC_STATE_SCISSOR;
+    if (renderer.dynamicTopology)
+        state->states[stateCount++] = VK_DYNAMIC_STATE_PRIMITIVE_TOPOLOGY_EXT;
+    if (renderer.dynamicCullMode)
+        state->states[stateCount++] = VK_DYNAMIC_STATE_CULL_MODE_EXT;
+    if (renderer.dynamicBlend)
+    {
+        state->states[stateCount++] = VK_DYNAMIC_STATE_COLOR_BLEND_ENABLE_EXT;
+        state->states[stateCount++] = VK_DYNAMIC_STATE_COLOR_BLEND_EQUATION_EXT;
+    }
 
-    VkPipelineDynamicStateCreateInfo dynamicState = {};
+    VkPipelineDynamicStateCreateInfo &dynamicState = state->dynamicState;
     dynamicState.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
     dynamicState.pNext = nullptr;
     dynamicState.flags = 0;
-    dynamicState.dynamicStateCount = (uint32_t)states.size();
-    dynamicState.pDynamicStates = states.data();
+    dynamicState.dynamicStateCount = stateCount;
+    dynamicState.pDynamicStates = state->states;
 
-    pipeline->setLayouts.resize(shader->sets.size());
+    // Every declared constant gets a value, stages simply ignore the ids they don't use
+    VkSpecializationInfo &specialization = state->specialization;
+    specialization.mapEntryCount = 0;
+    specialization.pMapEntries = state->entries;
+    specialization.dataSize = 0;
+    specialization.pData = state->values;
 
-    VkDescriptorSetLayoutCreateInfo setLayoutInfo = {};
-    setLayoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
-    setLayoutInfo.pNext = nullptr;
-    setLayoutInfo.flags = 0;
-    
-    for (uint32_t i = 0; i < (uint32_t)shader->sets.size(); ++i)
+    for (uint32_t id = 0; id < 32; ++id)
     {
-        setLayoutInfo.bindingCount = (uint32_t)shader->sets[i].bindings.size();
-        setLayoutInfo.pBindings = shader->sets[i].bindings.data();
+        if (!(shader->specConstantMask & (1u << id)))
+            continue;
 
-        VkCheck(vkCreateDescriptorSetLayout(renderer.device, &setLayoutInfo, nullptr, &pipeline->setLayouts[i]));
-    }
+        VkSpecializationMapEntry &entry = state->entries[specialization.mapEntryCount];
+        entry.constantID = id;
+        entry.offset = specialization.mapEntryCount * sizeof(VkBool32);
+        entry.size = sizeof(VkBool32);
+
+        state->values[specialization.mapEntryCount] = (key.specialization >> id) & 1;
 
-    VkPipelineLayoutCreateInfo layoutInfo = {};
-    layoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-    layoutInfo.pNext = nullptr;
-    layoutInfo.flags = 0;
-    layoutInfo.setLayoutCount = (uint32_t)pipeline->setLayouts.size();
-    layoutInfo.pSetLayouts = pipeline->setLayouts.data();
-    layoutInfo.pushConstantRangeCount = (uint32_t)shader->ranges.size();
-    layoutInfo.pPushConstantRanges = shader->ranges.data();
+        specialization.mapEntryCount++;
+        specialization.dataSize += sizeof(VkBool32);
+    }
 
-    VkCheck(vkCreatePipelineLayout(renderer.device, &layoutInfo, nullptr, &pipeline->layout));
+    state->stages = shader->stages;
+    if (specialization.mapEntryCount > 0)
+    {
+        for (VkPipelineShaderStageCreateInfo &stage : state->stages)
+        {
+            stage.pSpecializationInfo = &state->specialization;
+        }
+    }
 
-    VkGraphicsPipelineCreateInfo pipelineInfo = {};
+    VkGraphicsPipelineCreateInfo &pipelineInfo = state->pipelineInfo;
     pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
     pipelineInfo.pNext = nullptr;
     pipelineInfo.flags = 0;
-    pipelineInfo.stageCount = (uint32_t)shader->stages.size();
-    pipelineInfo.pStages = shader->stages.data();
-    pipelineInfo.pVertexInputState = &vertexInputStage;
-    pipelineInfo.pInputAssemblyState = &inputAssemblyState;
+    pipelineInfo.stageCount = (uint32_t)state->stages.size();
+    pipelineInfo.pStages = state->stages.data();
+    pipelineInfo.pVertexInputState = &state->vertexInputStage;
+    pipelineInfo.pInputAssemblyState = &state->inputAssemblyState;
     pipelineInfo.pTessellationState = nullptr;
-    pipelineInfo.pViewportState = &viewportState;
-    pipelineInfo.pRasterizationState = &rasterizationState;
-    pipelineInfo.pMultisampleState = &multisampleState;
+    pipelineInfo.pViewportState = &state->viewportState;
+    pipelineInfo.pRasterizationState = &state->rasterizationState;
+    pipelineInfo.pMultisampleState = &state->multisampleState;
     pipelineInfo.pDepthStencilState = nullptr;
-    pipelineInfo.pColorBlendState = &colorBlendState;
-    pipelineInfo.pDynamicState = &dynamicState;
+    pipelineInfo.pColorBlendState = &state->colorBlendState;
+    pipelineInfo.pDynamicState = &state->dynamicState;
     pipelineInfo.layout = pipeline->layout;
-    pipelineInfo.renderPass = renderer.renderPass;
+    pipelineInfo.renderPass = GetCompatibleRenderPass(key.format);
     pipelineInfo.subpass = 0;
     pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
     pipelineInfo.basePipelineIndex = -1;
+}
+
+VkPipeline GetPipelineVariant(GraphicsPipeline *pipeline, const PipelineKey &key)
+{
+    PipelineKey normalized = NormalizePipelineKey(pipeline, key);
+
+    auto it = pipeline->variants.find(normalized);
+    if (it != pipeline->variants.end())
+        return it->second;
+
+    ZoneScopedN("Create pipeline variant");
 
-    VkCheck(vkCreateGraphicsPipelines(renderer.device, renderer.cache, 1, &pipelineInfo, nullptr, &pipeline->pipeline));
+    PipelineState state;
+    InitPipelineState(&state, pipeline, normalized);
+
+    VkPipeline variant;
+    VkCheck(vkCreateGraphicsPipelines(renderer.device, renderer.cache, 1, &state.pipelineInfo, nullptr, &variant));
+
+    std::lock_guard<std::mutex> lock(variantMutex);
+    pipeline->variants[normalized] = variant;
+
+    return variant;
+}
+
+std::vector<PipelineKey> GetPipelineVariantKeys(GraphicsPipeline *pipeline)
+{
+    std::lock_guard<std::mutex> lock(variantMutex);
+
+    std::vector<PipelineKey> keys;
+    keys.reserve(pipeline->variants.size());
+
+    for (const auto &variant : pipeline->variants)
+    {
+        keys.push_back(variant.first);
+    }
+
+    return keys;
+}
+
+void ReplaceGraphicsPipeline(GraphicsPipeline *target, GraphicsPipeline *replacement)
+{
+    std::lock_guard<std::mutex> lock(variantMutex);
+
+    std::swap(*target, *replacement);
+}
+
+VkResult CreatePipelineVariants(const PipelineVariantRequest *requests, uint32_t count)
+{
+    ZoneScopedN("CreatePipelineVariants");
+
+    struct PendingVariant
+    {
+        GraphicsPipeline *pipeline;
+        PipelineKey key;
+        VkPipeline variant;
+        VkResult result;
+    };
+
+    std::vector<PendingVariant> pending;
+    pending.reserve(count);
+
+    // Reserved up front, the create infos point into their own entry
+    std::vector<PipelineState> states(count);
+
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        GraphicsPipeline *pipeline = requests[i].pipeline;
+        PipelineKey key = NormalizePipelineKey(pipeline, requests[i].key);
+
+        // Also skips duplicates within the batch, the placeholder is replaced below
+        if (pipeline->variants.count(key))
+            continue;
+
+        {
+            std::lock_guard<std::mutex> lock(variantMutex);
+            pipeline->variants[key] = VK_NULL_HANDLE;
+        }
+
+        InitPipelineState(&states[pending.size()], pipeline, key);
+        pending.push_back({ pipeline, key, VK_NULL_HANDLE, VK_SUCCESS });
+    }
+
+    // Pipeline creation and the pipeline cache are both safe to use from several threads at once.
+    // Results are returned rather than passed to VkCheck, which writes renderer.result, since the hot
+    // reload thread builds variants too.
+    ParallelFor((uint32_t)pending.size(), 1, [&](uint32_t begin, uint32_t end)
+    {
+        for (uint32_t i = begin; i < end; ++i)
+        {
+            pending[i].result = vkCreateGraphicsPipelines(renderer.device, renderer.cache, 1, &states[i].pipelineInfo, nullptr, &pending[i].variant);
+        }
+    });
+
+    VkResult result = VK_SUCCESS;
+
+    std::lock_guard<std::mutex> lock(variantMutex);
+
+    for (PendingVariant &variant : pending)
+    {
+        if (variant.result == VK_SUCCESS)
+        {
+            variant.pipeline->variants[variant.key] = variant.variant;
+        }
+        else
+        {
+            variant.pipeline->variants.erase(variant.key);
+
+            if (result == VK_SUCCESS)
+                result = variant.result;
+        }
+    }
+
+    return result;
 }
 
 void DestroyGraphicsPipeline(GraphicsPipeline *pipeline)
 {
-    for (uint32_t i = 0; i < pipeline->setLayouts.size(); ++i)
+    for (auto &variant : pipeline->variants)
     {
-        vkDestroyDescriptorSetLayout(renderer.device, pipeline->setLayouts[i], nullptr);
+        vkDestroyPipeline(renderer.device, variant.second, nullptr);
     }
 
-    vkDestroyPipelineLayout(renderer.device, pipeline->layout, nullptr);
-    vkDestroyPipeline(renderer.device, pipeline->pipeline, nullptr);
+    pipeline->variants.clear();
+
+    // Layouts belong to the layout cache and may be shared with other pipelines
+    DestroyShader(&pipeline->shader);
 }
\ No newline at end of file
@@ -2,15 +2,76 @@
 
 #include <volk.h>
 
+#include <unordered_map>
+#include <vector>
+
+#include "Hash.h"
 #include "Shader.h"
+#include "Renderer.h"
+
+// Everything a pipeline variant depends on besides the shader. Render passes with the same
+// attachment format and sample count are compatible, so the format stands in for the pass.
+struct PipelineKey
+{
+    VkPrimitiveTopology topology;
+    BlendMode blendMode;
+    VkFormat format;
+    VkSampleCountFlagBits samples;
 
+    // Bit n sets the boolean specialization constant with constant_id n, see ShaderFeature.
+    // Bits the shader doesn't declare are dropped, so they never create duplicate variants.
+    uint32_t specialization;
+};
+
+inline bool operator==(const PipelineKey &a, const PipelineKey &b)
+{
+    return a.topology == b.topology && a.blendMode == b.blendMode && a.format == b.format && a.samples == b.samples && a.specialization == b.specialization;
+}
+
+struct PipelineKeyHash
+{
+    size_t operator()(const PipelineKey &key) const
+    {
+        return (size_t)HashMemory(&key, sizeof(key));
+    }
+};
+
+// A shader with its layouts, which come from the layout cache. Its VkPipelines are built on first use for each PipelineKey, so
+// adding blend modes or targets does not multiply the pipelines built at startup.
 struct GraphicsPipeline
 {
-    VkPipelineLayout layout;
-    VkPipeline pipeline;
+    Shader shader;
 
+    VkPipelineLayout layout;
     std::vector<VkDescriptorSetLayout> setLayouts;
+
+    std::unordered_map<PipelineKey, VkPipeline, PipelineKeyHash> variants;
+};
+
+// Takes ownership of the shader's modules, they are kept for creating variants later
+void CreateGraphicsPipeline(GraphicsPipeline *pipeline, Shader *shader);
+void DestroyGraphicsPipeline(GraphicsPipeline *pipeline);
+
+VkPipeline GetPipelineVariant(GraphicsPipeline *pipeline, const PipelineKey &key);
+
+// Safe to call from other threads while the render thread draws, for rebuilding a pipeline with the
+// variants it already has
+std::vector<PipelineKey> GetPipelineVariantKeys(GraphicsPipeline *pipeline);
+
+// Moves replacement into target, and the previous contents of target into replacement. Only called on the
+// render thread, but guarded against GetPipelineVariantKeys.
+void ReplaceGraphicsPipeline(GraphicsPipeline *target, GraphicsPipeline *replacement);
+
+// Only valid when renderer.dynamicBlend is set, variants then ignore the key's blend mode
+void CmdSetBlendMode(VkCommandBuffer commandBuffer, BlendMode mode);
+
+struct PipelineVariantRequest
+{
+    GraphicsPipeline *pipeline;
+    PipelineKey key;
 };
 
-void CreateGraphicsPipeline(GraphicsPipeline *pipeline, Shader *shader, VkPrimitiveTopology topology);
-void DestroyGraphicsPipeline(GraphicsPipeline *pipeline);
\ No newline at end of file
+// Creates the variants that don't exist yet across the job system, for building everything
+// a scene needs up front instead of hitching on first use. Returns the first failure, failed variants
+// are left to be retried on first use.
+VkResult CreatePipelineVariants(const PipelineVariantRequest *requests, uint32_t count);
\ No newline at end of file
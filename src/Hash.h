@@ -0,0 +1,37 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+// 64 bit hash for cache keys, consumes 8 bytes per step
+inline uint64_t HashMemory(const void *data, size_t size, uint64_t seed = 0)
+{
+    const uint64_t prime = 0x9E3779B97F4A7C15ull;
+
+    const uint8_t *bytes = (const uint8_t *)data;
+    uint64_t hash = seed ^ (size * prime);
+
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8)
+    {
+        uint64_t word;
+        memcpy(&word, bytes + i, sizeof(word));
+
+        hash ^= word * prime;
+        hash = (hash << 31) | (hash >> 33);
+        hash *= 0xBF58476D1CE4E5B9ull;
+    }
+
+    for (; i < size; ++i)
+    {
+        hash ^= bytes[i];
+        hash *= prime;
+    }
+
+    hash ^= hash >> 29;
+    hash *= 0x94D049BB133111EBull;
+    hash ^= hash >> 32;
+
+    return hash;
+}
\ No newline at end of file
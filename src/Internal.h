@@ -1,14 +1,18 @@
 #pragma once
 
 #include <vector>
+#include <string>
 #include <deque>
 #include <functional>
+#include <unordered_map>
 
 #include <volk.h>
 #include <vk_mem_alloc.h>
 
 #ifdef _WIN32
 #include "Win32Platform.h"
+#elif defined(__linux__)
+#include "LinuxPlatform.h"
 #endif
 
 #include "Swapchain.h"
@@ -16,6 +20,9 @@
 #include "Shader.h"
 #include "Buffer.h"
 #include "Texture.h"
+#include "StagingRing.h"
+#include "Material.h"
+#include "SpriteBatch.h"
 
 #include "Renderer.h"
 
@@ -31,8 +38,37 @@ struct FrameResources
 
     VkCommandBuffer commandBuffer;
 
+    // Transfers recorded during the frame, submitted ahead of commandBuffer
+    VkCommandBuffer uploadCommandBuffer;
+    bool uploadRecording;
+
+    StagingRing stagingRing;
+
+    // Material parameters, bound through paramSet with a dynamic offset per draw
+    StagingRing paramRing;
+    VkDescriptorSet paramSet;
+    bool paramRingOverflowed;
+
+    // Expanded sprite batches, drawn straight from this mapped memory
+    StagingRing vertexRing;
+    bool vertexRingOverflowed;
+
+    // BatchShapeData of shape batches, one record per quad that fits in vertexRing so a quad's record is
+    // found from its vertex offset. Never allocated from, it is regrown along with vertexRing.
+    StagingRing shapeRing;
+    VkDescriptorSet shapeSet;
+
+    // 32 bit indices of batched paths and polygons, their vertices go to vertexRing
+    StagingRing indexRing;
+    bool indexRingOverflowed;
+
+    // Set once renderFinishedFence has been waited on for the current use of this frame
+    bool acquired;
+
     VkDescriptorSet frameUBO;
     Buffer frameBuffer;
+
+    std::deque<std::function<void ()>> deletionQueue;
 };
 
 struct _Window
@@ -65,31 +101,71 @@ struct Renderer
     VkSurfaceKHR surface;
 
     VkRenderPass renderPass;
-    VkRenderPass toTexturePass;
     VkRenderPass midRenderPass;
+    std::unordered_map<VkFormat, VkRenderPass> targetPasses;
     
     Swapchain swapchain;
     std::vector<FrameResources> frames;
     std::vector<VkFramebuffer> framebuffers;
     uint32_t frameIndex;
     uint32_t currentImage;
+    uint64_t frameCounter;
 
     Texture *currentTarget;
+    VkFormat currentTargetFormat;
+    BlendMode blendMode;
 
     VkPipelineCache cache;
     GraphicsPipeline texturePipeline;
-    GraphicsPipeline colorQuadPipeline;
-    GraphicsPipeline linePipeline;
+    GraphicsPipeline colorPipeline;
+    GraphicsPipeline spritePipeline;
+    GraphicsPipeline shapePipeline;
+
+    // Sprites queued since the last flush, all drawn with batchTexture. A handle rather than a _Texture *,
+    // since textures created while the batch fills (glyph pages, loads) may reallocate the pool.
+    SpriteStream spriteBatch;
+    Texture *batchTexture;
+
+    // Path and polygon triangles queued since the last flush, drawn untextured with the sprite pipeline.
+    // Only one of the two batches holds anything at a time, so draw order is kept.
+    std::vector<BatchVertex> geometryVertices;
+    std::vector<uint32_t> geometryIndices;
 
     VmaAllocator allocator;
     TracyVkCtx ctx;
 
+    bool memoryBudgetSupported;
+
+    // Extended dynamic state, each one folds that part of the PipelineKey into command buffer state
+    bool dynamicTopology;
+    bool dynamicCullMode;
+    bool dynamicBlend;
+
+    TexturePool texturePool;
+    uint64_t residentTextureBytes;
+    uint64_t textureBudget;
+
+    // Keyed by hash of the normalized path or of the pixel contents, both combined with the format
+    std::unordered_map<uint64_t, TextureCacheEntry> textureCache;
+
+    // Keyed by hash of the shader paths and defines
+    std::unordered_map<uint64_t, MaterialProgram *> materialPrograms;
+    uint32_t uniformAlignment;
+
+    Texture *whiteTexture;
+
     Buffer quadVertexBuffer;
+    Buffer quadIndexBuffer;
     Buffer lineVertexBuffer;
 
     Buffer *lastBuffer;
-    GraphicsPipeline *lastPipeline;
+    Buffer *lastIndexBuffer;
+    VkPipeline lastPipeline;
+    VkPrimitiveTopology lastTopology;
+    BlendMode lastBlendMode;
     uint64_t lastSetHash;
+    VkPipelineLayout lastLayout;
+    uint32_t lastDynamicOffset;
 
     VkResult result;
 
@@ -110,11 +186,57 @@ struct Renderer
     };
 };
 
+struct _Mesh
+{
+    Buffer vertexBuffer;
+    Buffer indexBuffer;
+
+    uint32_t vertexCount;
+    uint32_t indexCount;    // 0 when drawn without indices
+};
+
+struct MappedFile
+{
+    const uint8_t *data;
+    size_t size;
+
+    PLATFORM_MAPPED_FILE;
+};
+
+struct FileWatcher
+{
+    PLATFORM_FILE_WATCHER;
+};
+
 extern Renderer renderer;
 
+inline TextureHot &GetTextureHot(_Texture *texture)
+{
+    return renderer.texturePool.hot[texture->index];
+}
+
+FrameResources &AcquireCurrentFrame();
+VkCommandBuffer GetUploadCommandBuffer();
+StagingAllocation AllocateStaging(uint32_t size, uint32_t alignment);
+
+VkRenderPass GetTargetRenderPass(VkFormat format);
+
 void PlatformCreateWindow(_Window *window);
 void PlatformDestroyWindow(_Window *window);
 
 void PlatformPollWindowEvents(_Window *window);
 
-VkSurfaceKHR PlatformGetSurface(_Window *window);
\ No newline at end of file
+VkSurfaceKHR PlatformGetSurface(_Window *window);
+
+bool PlatformMapFile(MappedFile *file, const char *path);
+void PlatformUnmapFile(MappedFile *file);
+
+bool PlatformCreateDirectory(const char *path);
+bool PlatformReplaceFile(const char *source, const char *destination);    // Atomically moves source over destination
+
+// Non-recursive. WaitForFileChanges blocks until files in the directory are written or renamed and
+// returns their names, or returns false once CancelFileWatch is called from another thread.
+bool PlatformWatchDirectory(FileWatcher *watcher, const char *path);
+bool PlatformWaitForFileChanges(FileWatcher *watcher, std::vector<std::string> *changed);
+void PlatformCancelFileWatch(FileWatcher *watcher);
+void PlatformCloseFileWatch(FileWatcher *watcher);
\ No newline at end of file
@@ -0,0 +1,169 @@
+#include "JobSystem.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+struct JobSystem
+{
+    std::vector<std::thread> workers;
+
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::deque<std::function<void ()>> jobs;
+
+    bool quit;
+};
+
+static JobSystem jobSystem;
+
+static void WorkerLoop()
+{
+    for (;;)
+    {
+        std::function<void ()> job;
+
+        {
+            std::unique_lock<std::mutex> lock(jobSystem.mutex);
+            jobSystem.wake.wait(lock, []() { return jobSystem.quit || !jobSystem.jobs.empty(); });
+
+            if (jobSystem.jobs.empty())
+                return;
+
+            job = std::move(jobSystem.jobs.front());
+            jobSystem.jobs.pop_front();
+        }
+
+        job();
+    }
+}
+
+void InitJobSystem(uint32_t workerCount /* = 0 */)
+{
+    if (!jobSystem.workers.empty())
+        return;
+
+    if (workerCount == 0)
+    {
+        uint32_t cores = std::thread::hardware_concurrency();
+        workerCount = cores > 1 ? cores - 1 : 0;
+    }
+
+    jobSystem.quit = false;
+
+    for (uint32_t i = 0; i < workerCount; ++i)
+    {
+        jobSystem.workers.emplace_back(WorkerLoop);
+    }
+}
+
+void ShutdownJobSystem()
+{
+    {
+        std::lock_guard<std::mutex> lock(jobSystem.mutex);
+        jobSystem.quit = true;
+    }
+
+    jobSystem.wake.notify_all();
+
+    for (std::thread &worker : jobSystem.workers)
+    {
+        worker.join();
+    }
+
+    jobSystem.workers.clear();
+}
+
+uint32_t GetJobWorkerCount()
+{
+    return (uint32_t)jobSystem.workers.size();
+}
+
+// Batches are claimed from a shared counter, so a helper job that starts late simply finds nothing
+// left to do. The state is reference counted because helpers can outlive the ParallelFor call.
+struct ParallelForState
+{
+    std::function<void (uint32_t, uint32_t)> func;
+
+    uint32_t count;
+    uint32_t batchSize;
+    uint32_t batchCount;
+
+    std::atomic<uint32_t> nextBatch;
+    std::atomic<uint32_t> finishedBatches;
+
+    std::mutex mutex;
+    std::condition_variable done;
+};
+
+static void RunBatches(ParallelForState *state)
+{
+    for (;;)
+    {
+        uint32_t batch = state->nextBatch.fetch_add(1);
+        if (batch >= state->batchCount)
+            return;
+
+        uint32_t begin = batch * state->batchSize;
+        uint32_t end = begin + state->batchSize < state->count ? begin + state->batchSize : state->count;
+
+        state->func(begin, end);
+
+        if (state->finishedBatches.fetch_add(1) + 1 == state->batchCount)
+        {
+            std::lock_guard<std::mutex> lock(state->mutex);
+            state->done.notify_all();
+        }
+    }
+}
+
+void ParallelFor(uint32_t count, uint32_t minBatch, const std::function<void (uint32_t begin, uint32_t end)> &func)
+{
+    if (count == 0)
+        return;
+
+    uint32_t threads = (uint32_t)jobSystem.workers.size() + 1;
+    if (minBatch == 0)
+        minBatch = 1;
+
+    // A few batches per thread evens out rows that take longer than others
+    uint32_t batchSize = (count + threads * 4 - 1) / (threads * 4);
+    if (batchSize < minBatch)
+        batchSize = minBatch;
+
+    uint32_t batchCount = (count + batchSize - 1) / batchSize;
+    if (threads == 1 || batchCount == 1)
+    {
+        func(0, count);
+        return;
+    }
+
+    std::shared_ptr<ParallelForState> state = std::make_shared<ParallelForState>();
+    state->func = func;
+    state->count = count;
+    state->batchSize = batchSize;
+    state->batchCount = batchCount;
+    state->nextBatch = 0;
+    state->finishedBatches = 0;
+
+    uint32_t helpers = batchCount - 1 < threads - 1 ? batchCount - 1 : threads - 1;
+
+    {
+        std::lock_guard<std::mutex> lock(jobSystem.mutex);
+        for (uint32_t i = 0; i < helpers; ++i)
+        {
+            jobSystem.jobs.push_back([state]() { RunBatches(state.get()); });
+        }
+    }
+
+    jobSystem.wake.notify_all();
+
+    RunBatches(state.get());
+
+    std::unique_lock<std::mutex> lock(state->mutex);
+    state->done.wait(lock, [&]() { return state->finishedBatches.load() == state->batchCount; });
+}
\ No newline at end of file
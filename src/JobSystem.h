@@ -0,0 +1,16 @@
+#pragma once
+
+#include <stdint.h>
+
+#include <functional>
+
+// Persistent worker threads shared by every parallel task in the renderer. Without workers
+// (before InitJobSystem, or on a single core machine) everything runs on the calling thread.
+void InitJobSystem(uint32_t workerCount = 0);   // 0 uses one worker per core, minus the calling thread
+void ShutdownJobSystem();
+
+uint32_t GetJobWorkerCount();
+
+// Splits [0, count) into batches of at least minBatch and runs them across the workers and the
+// calling thread, returns once every batch has finished
+void ParallelFor(uint32_t count, uint32_t minBatch, const std::function<void (uint32_t begin, uint32_t end)> &func);
\ No newline at end of file
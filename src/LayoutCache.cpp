@@ -0,0 +1,139 @@
+#include "LayoutCache.h"
+
+#include "Internal.h"
+#include "Utils.h"
+
+#include <algorithm>
+#include <mutex>
+#include <unordered_map>
+
+// The key words are kept next to the handle so a hash collision can't hand out the wrong layout
+template <typename T>
+struct CachedLayout
+{
+    std::vector<uint64_t> key;
+    T layout;
+};
+
+struct LayoutCache
+{
+    std::mutex mutex;
+
+    std::unordered_multimap<uint64_t, CachedLayout<VkDescriptorSetLayout>> setLayouts;
+    std::unordered_multimap<uint64_t, CachedLayout<VkPipelineLayout>> pipelineLayouts;
+};
+
+static LayoutCache layoutCache;
+
+template <typename T>
+static bool FindLayout(const std::unordered_multimap<uint64_t, CachedLayout<T>> &map, uint64_t hash, const std::vector<uint64_t> &key, T *layout)
+{
+    auto range = map.equal_range(hash);
+    for (auto it = range.first; it != range.second; ++it)
+    {
+        if (it->second.key == key)
+        {
+            *layout = it->second.layout;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+VkDescriptorSetLayout GetDescriptorSetLayout(const DescriptorSetData &set)
+{
+    // Reflection order isn't guaranteed, the same bindings in any order make the same layout
+    std::vector<VkDescriptorSetLayoutBinding> bindings = set.bindings;
+    std::sort(bindings.begin(), bindings.end(), [](const VkDescriptorSetLayoutBinding &a, const VkDescriptorSetLayoutBinding &b)
+    {
+        return a.binding < b.binding;
+    });
+
+    std::vector<uint64_t> key;
+    for (const VkDescriptorSetLayoutBinding &binding : bindings)
+    {
+        key.push_back((uint64_t)binding.binding | ((uint64_t)binding.descriptorType << 32));
+        key.push_back((uint64_t)binding.descriptorCount | ((uint64_t)binding.stageFlags << 32));
+        key.push_back((uint64_t)(uintptr_t)binding.pImmutableSamplers);
+    }
+
+    uint64_t hash = HashMemory(key.data(), key.size() * sizeof(uint64_t));
+
+    std::lock_guard<std::mutex> lock(layoutCache.mutex);
+
+    VkDescriptorSetLayout layout;
+    if (FindLayout(layoutCache.setLayouts, hash, key, &layout))
+        return layout;
+
+    VkDescriptorSetLayoutCreateInfo setLayoutInfo = {};
+    setLayoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    setLayoutInfo.pNext = nullptr;
+    setLayoutInfo.flags = 0;
+    setLayoutInfo.bindingCount = (uint32_t)bindings.size();
+    setLayoutInfo.pBindings = bindings.data();
+
+    VkCheck(vkCreateDescriptorSetLayout(renderer.device, &setLayoutInfo, nullptr, &layout));
+
+    layoutCache.setLayouts.insert({ hash, { key, layout } });
+
+    return layout;
+}
+
+VkPipelineLayout GetPipelineLayout(const std::vector<VkDescriptorSetLayout> &setLayouts, const std::vector<VkPushConstantRange> &ranges)
+{
+    // Set layouts are already deduplicated, so their handles identify them
+    std::vector<uint64_t> key;
+    key.push_back(setLayouts.size());
+    for (VkDescriptorSetLayout setLayout : setLayouts)
+    {
+        key.push_back((uint64_t)setLayout);
+    }
+
+    for (const VkPushConstantRange &range : ranges)
+    {
+        key.push_back((uint64_t)range.stageFlags);
+        key.push_back((uint64_t)range.offset | ((uint64_t)range.size << 32));
+    }
+
+    uint64_t hash = HashMemory(key.data(), key.size() * sizeof(uint64_t));
+
+    std::lock_guard<std::mutex> lock(layoutCache.mutex);
+
+    VkPipelineLayout layout;
+    if (FindLayout(layoutCache.pipelineLayouts, hash, key, &layout))
+        return layout;
+
+    VkPipelineLayoutCreateInfo layoutInfo = {};
+    layoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    layoutInfo.pNext = nullptr;
+    layoutInfo.flags = 0;
+    layoutInfo.setLayoutCount = (uint32_t)setLayouts.size();
+    layoutInfo.pSetLayouts = setLayouts.data();
+    layoutInfo.pushConstantRangeCount = (uint32_t)ranges.size();
+    layoutInfo.pPushConstantRanges = ranges.data();
+
+    VkCheck(vkCreatePipelineLayout(renderer.device, &layoutInfo, nullptr, &layout));
+
+    layoutCache.pipelineLayouts.insert({ hash, { key, layout } });
+
+    return layout;
+}
+
+void DestroyLayoutCache()
+{
+    std::lock_guard<std::mutex> lock(layoutCache.mutex);
+
+    for (auto &cached : layoutCache.pipelineLayouts)
+    {
+        vkDestroyPipelineLayout(renderer.device, cached.second.layout, nullptr);
+    }
+
+    for (auto &cached : layoutCache.setLayouts)
+    {
+        vkDestroyDescriptorSetLayout(renderer.device, cached.second.layout, nullptr);
+    }
+
+    layoutCache.pipelineLayouts.clear();
+    layoutCache.setLayouts.clear();
+}
\ No newline at end of file
@@ -0,0 +1,15 @@
+#pragma once
+
+#include <volk.h>
+
+#include <vector>
+
+#include "Shader.h"
+
+// Identical layouts share one handle, so descriptor sets allocated for one pipeline bind with any
+// other using the same layout, and a layout change reliably means the bound sets are invalid.
+// Handles live until DestroyLayoutCache, pipelines never destroy them.
+VkDescriptorSetLayout GetDescriptorSetLayout(const DescriptorSetData &set);
+VkPipelineLayout GetPipelineLayout(const std::vector<VkDescriptorSetLayout> &setLayouts, const std::vector<VkPushConstantRange> &ranges);
+
+void DestroyLayoutCache();
\ No newline at end of file
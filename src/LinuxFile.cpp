@@ -0,0 +1,139 @@
+#ifdef __linux__
+
+#include "Internal.h"
+
+#include "Utils.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+bool PlatformMapFile(MappedFile *file, const char *path)
+{
+    file->posix.fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (file->posix.fd < 0)
+        return false;
+
+    struct stat info;
+    if (fstat(file->posix.fd, &info) != 0 || info.st_size == 0)
+    {
+        close(file->posix.fd);
+        return false;
+    }
+
+    void *data = mmap(nullptr, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, file->posix.fd, 0);
+    if (data == MAP_FAILED)
+    {
+        close(file->posix.fd);
+        return false;
+    }
+
+    file->data = (const uint8_t *)data;
+    file->size = (size_t)info.st_size;
+
+    return true;
+}
+
+void PlatformUnmapFile(MappedFile *file)
+{
+    munmap((void *)file->data, file->size);
+    close(file->posix.fd);
+
+    file->data = nullptr;
+    file->size = 0;
+}
+
+bool PlatformCreateDirectory(const char *path)
+{
+    return mkdir(path, 0755) == 0 || errno == EEXIST;
+}
+
+bool PlatformReplaceFile(const char *source, const char *destination)
+{
+    return rename(source, destination) == 0;
+}
+
+bool PlatformWatchDirectory(FileWatcher *watcher, const char *path)
+{
+    watcher->inotify.fd = inotify_init1(IN_CLOEXEC);
+    if (watcher->inotify.fd < 0)
+        return false;
+
+    // Editors either rewrite the file in place or write a temporary and rename it over the original
+    watcher->inotify.watch = inotify_add_watch(watcher->inotify.fd, path, IN_CLOSE_WRITE | IN_MOVED_TO);
+    if (watcher->inotify.watch < 0)
+    {
+        close(watcher->inotify.fd);
+        return false;
+    }
+
+    watcher->inotify.cancelFd = eventfd(0, EFD_CLOEXEC);
+
+    return true;
+}
+
+bool PlatformWaitForFileChanges(FileWatcher *watcher, std::vector<std::string> *changed)
+{
+    pollfd fds[2] = {};
+    fds[0].fd = watcher->inotify.fd;
+    fds[0].events = POLLIN;
+    fds[1].fd = watcher->inotify.cancelFd;
+    fds[1].events = POLLIN;
+
+    for (;;)
+    {
+        if (poll(fds, 2, -1) < 0)
+        {
+            if (errno == EINTR)
+                continue;
+
+            return false;
+        }
+
+        if (fds[1].revents & POLLIN)
+            return false;
+
+        if (fds[0].revents & POLLIN)
+            break;
+    }
+
+    alignas(inotify_event) char buffer[4096];
+    ssize_t bytes = read(watcher->inotify.fd, buffer, sizeof(buffer));
+    if (bytes <= 0)
+        return false;
+
+    changed->clear();
+
+    for (ssize_t offset = 0; offset < bytes;)
+    {
+        const inotify_event *event = (const inotify_event *)(buffer + offset);
+        if (event->len > 0)
+            changed->push_back(event->name);
+
+        offset += sizeof(inotify_event) + event->len;
+    }
+
+    return true;
+}
+
+void PlatformCancelFileWatch(FileWatcher *watcher)
+{
+    uint64_t value = 1;
+    ssize_t written = write(watcher->inotify.cancelFd, &value, sizeof(value));
+    (void)written;
+}
+
+void PlatformCloseFileWatch(FileWatcher *watcher)
+{
+    inotify_rm_watch(watcher->inotify.fd, watcher->inotify.watch);
+    close(watcher->inotify.fd);
+    close(watcher->inotify.cancelFd);
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,16 @@
+#pragma once
+
+#define PLATFORM_MAPPED_FILE LinuxMappedFile posix;
+#define PLATFORM_FILE_WATCHER LinuxFileWatcher inotify;
+
+struct LinuxMappedFile
+{
+    int fd;
+};
+
+struct LinuxFileWatcher
+{
+    int fd;
+    int watch;
+    int cancelFd;   // eventfd written by PlatformCancelFileWatch
+};
\ No newline at end of file
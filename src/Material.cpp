@@ -0,0 +1,346 @@
+#include "Material.h"
+
+#include "Renderer.h"
+#include "Internal.h"
+#include "Utils.h"
+#include "LayoutCache.h"
+#include "ShaderHotReload.h"
+
+#include <string.h>
+
+// Copied from the texture pipeline at init, hot reload may swap that shader from under a worker
+struct SpriteLayout
+{
+    DescriptorSetData cameraSet;
+    DescriptorSetData textureSet;
+    std::vector<VkPushConstantRange> ranges;
+};
+
+static SpriteLayout spriteLayout;
+
+static DescriptorSetData GetMaterialParamSetData()
+{
+    DescriptorSetData data = {};
+    data.setIndex = MATERIAL_PARAMS_SET;
+
+    VkDescriptorSetLayoutBinding binding = {};
+    binding.binding = 0;
+    binding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+    binding.descriptorCount = 1;
+    binding.stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
+    binding.pImmutableSamplers = nullptr;
+
+    data.bindings.push_back(binding);
+
+    return data;
+}
+
+static void WriteFrameMaterialParamSet(FrameResources &frame)
+{
+    VkDescriptorBufferInfo bufferInfo = {};
+    bufferInfo.buffer = frame.paramRing.buffer.buffer;
+    bufferInfo.offset = 0;
+    bufferInfo.range = MATERIAL_PARAMS_SIZE;
+
+    VkWriteDescriptorSet write = {};
+    write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    write.pNext = nullptr;
+    write.dstSet = frame.paramSet;
+    write.dstBinding = 0;
+    write.dstArrayElement = 0;
+    write.descriptorCount = 1;
+    write.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+    write.pImageInfo = nullptr;
+    write.pBufferInfo = &bufferInfo;
+    write.pTexelBufferView = nullptr;
+
+    vkUpdateDescriptorSets(renderer.device, 1, &write, 0, nullptr);
+}
+
+void InitFrameMaterialParams(FrameResources &frame)
+{
+    CreateStagingRing(&frame.paramRing, MATERIAL_RING_SIZE, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, VMA_MEMORY_USAGE_CPU_TO_GPU);
+    frame.paramRingOverflowed = false;
+
+    VkDescriptorSetLayout layout = GetDescriptorSetLayout(GetMaterialParamSetData());
+
+    VkDescriptorSetAllocateInfo allocInfo = {};
+    allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    allocInfo.pNext = nullptr;
+    allocInfo.descriptorPool = renderer.descriptorPool;
+    allocInfo.descriptorSetCount = 1;
+    allocInfo.pSetLayouts = &layout;
+
+    VkCheck(vkAllocateDescriptorSets(renderer.device, &allocInfo, &frame.paramSet));
+
+    WriteFrameMaterialParamSet(frame);
+}
+
+void DestroyFrameMaterialParams(FrameResources &frame)
+{
+    DestroyStagingRing(&frame.paramRing);
+}
+
+void ResetFrameMaterialParams(FrameResources &frame)
+{
+    if (frame.paramRingOverflowed)
+    {
+        uint32_t size = frame.paramRing.buffer.size * 2;
+
+        DestroyStagingRing(&frame.paramRing);
+        CreateStagingRing(&frame.paramRing, size, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, VMA_MEMORY_USAGE_CPU_TO_GPU);
+
+        // Nothing in flight uses this frame's set anymore
+        WriteFrameMaterialParamSet(frame);
+
+        frame.paramRingOverflowed = false;
+    }
+
+    ResetStagingRing(&frame.paramRing);
+}
+
+void InitMaterials()
+{
+    VkPhysicalDeviceProperties properties = {};
+    vkGetPhysicalDeviceProperties(renderer.physicalDevice, &properties);
+
+    renderer.uniformAlignment = (uint32_t)properties.limits.minUniformBufferOffsetAlignment;
+
+    const Shader &sprite = renderer.texturePipeline.shader;
+    spriteLayout.cameraSet = sprite.sets[0];
+    spriteLayout.textureSet = sprite.sets[1];
+    spriteLayout.ranges = sprite.ranges;
+
+    uint8_t white[4] = { 255, 255, 255, 255 };
+    renderer.whiteTexture = LoadTextureFromPixels(1, 1, white);
+}
+
+static void ReleaseMaterialProgram(MaterialProgram *program)
+{
+    UnregisterReloadablePipeline(&program->pipeline);
+    renderer.materialPrograms.erase(program->key);
+
+    // Earlier frames may still be drawing with it
+    AcquireCurrentFrame().deletionQueue.push_back([=]()
+    {
+        DestroyGraphicsPipeline(&program->pipeline);
+        delete program;
+    });
+}
+
+void ShutdownMaterials()
+{
+    // Materials the application never destroyed
+    while (!renderer.materialPrograms.empty())
+    {
+        ReleaseMaterialProgram(renderer.materialPrograms.begin()->second);
+    }
+
+    DestroyTexture(renderer.whiteTexture);
+    renderer.whiteTexture = nullptr;
+}
+
+static bool IsMaterialBinding(uint32_t set, const VkDescriptorSetLayoutBinding &binding)
+{
+    if (binding.binding != 0)
+        return false;
+
+    switch (set)
+    {
+        case 0: return binding.descriptorType == VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+        case 1: return binding.descriptorType == VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        case MATERIAL_PARAMS_SET: return binding.descriptorType == VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+        default: return false;
+    }
+}
+
+// Replaces the reflected layout with the sprite one, so every material shares its sets and push
+// constants with the built-in pipelines and binds without disturbing them
+static bool PrepareMaterialShader(Shader *shader, std::vector<UniformMember> *params, uint32_t *paramsSize, std::string *log)
+{
+    for (uint32_t set = 0; set < (uint32_t)shader->sets.size(); ++set)
+    {
+        for (const VkDescriptorSetLayoutBinding &binding : shader->sets[set].bindings)
+        {
+            if (!IsMaterialBinding(set, binding))
+            {
+                *log = "Material shaders can only use the camera block (set 0), a sampler2D (set 1) and a parameter block (set 2), all at binding 0";
+                return false;
+            }
+        }
+    }
+
+    params->clear();
+    *paramsSize = 0;
+
+    for (const UniformMember &member : shader->uniforms)
+    {
+        if (member.set != MATERIAL_PARAMS_SET || member.binding != 0)
+            continue;
+
+        params->push_back(member);
+
+        if (member.offset + member.size > *paramsSize)
+            *paramsSize = member.offset + member.size;
+    }
+
+    if (*paramsSize > MATERIAL_PARAMS_SIZE)
+    {
+        *log = "Material parameter block is " + std::to_string(*paramsSize) + " bytes, the limit is " + std::to_string(MATERIAL_PARAMS_SIZE);
+        return false;
+    }
+
+    shader->sets.resize(MATERIAL_PARAMS_SET + 1);
+    shader->sets[0] = spriteLayout.cameraSet;
+    shader->sets[1] = spriteLayout.textureSet;
+    shader->sets[MATERIAL_PARAMS_SET] = GetMaterialParamSetData();
+
+    shader->ranges = spriteLayout.ranges;
+
+    return true;
+}
+
+static bool IsSameParamLayout(const std::vector<UniformMember> &a, const std::vector<UniformMember> &b)
+{
+    if (a.size() != b.size())
+        return false;
+
+    for (size_t i = 0; i < a.size(); ++i)
+    {
+        if (a[i].name != b[i].name || a[i].offset != b[i].offset || a[i].size != b[i].size || a[i].components != b[i].components || a[i].integer != b[i].integer)
+            return false;
+    }
+
+    return true;
+}
+
+static MaterialProgram *AcquireMaterialProgram(const char *vertPath, const char *fragPath, const char *defines)
+{
+    uint64_t key = HashMemory(vertPath, strlen(vertPath));
+    key = HashMemory(fragPath, strlen(fragPath), key);
+    key = HashMemory(defines, strlen(defines), key);
+
+    auto it = renderer.materialPrograms.find(key);
+    if (it != renderer.materialPrograms.end())
+    {
+        it->second->refCount++;
+        return it->second;
+    }
+
+    Shader shader = {};
+    ShaderSource source = { vertPath, fragPath, defines };
+
+    std::string log;
+    if (!TryCreateShaders(&shader, &source, 1, &log))
+    {
+        printf("%s\n", log.c_str());
+        return nullptr;
+    }
+
+    MaterialProgram *program = new MaterialProgram();
+    program->key = key;
+    program->refCount = 1;
+
+    if (!PrepareMaterialShader(&shader, &program->params, &program->paramsSize, &log))
+    {
+        printf("%s: %s\n", fragPath, log.c_str());
+
+        DestroyShader(&shader);
+        delete program;
+
+        return nullptr;
+    }
+
+    CreateGraphicsPipeline(&program->pipeline, &shader);
+
+    // Existing materials hold parameters in the old layout, so reloads may change code but not the block
+    RegisterReloadablePipeline(&program->pipeline, vertPath, fragPath, defines, [=](Shader *reloaded, std::string *reloadLog)
+    {
+        std::vector<UniformMember> params;
+        uint32_t paramsSize;
+
+        if (!PrepareMaterialShader(reloaded, &params, &paramsSize, reloadLog))
+            return false;
+
+        if (!IsSameParamLayout(params, program->params))
+        {
+            *reloadLog = "The parameter block changed, restart to apply it";
+            return false;
+        }
+
+        return true;
+    });
+
+    renderer.materialPrograms[key] = program;
+
+    return program;
+}
+
+Material *CreateMaterial(const char *vertPath, const char *fragPath, const MaterialOptions &options /* = {} */)
+{
+    MaterialProgram *program = AcquireMaterialProgram(vertPath, fragPath, options.defines ? options.defines : "");
+    if (!program)
+        return nullptr;
+
+    _Material *material = new _Material();
+    material->program = program;
+    memset(material->params, 0, sizeof(material->params));
+
+    return (Material *)material;
+}
+
+void DestroyMaterial(Material *handle)
+{
+    _Material *material = (_Material *)handle;
+
+    // Parameters are copied into the frame's ring at draw time, so the material itself can go right away
+    if (--material->program->refCount == 0)
+        ReleaseMaterialProgram(material->program);
+
+    delete material;
+}
+
+static void SetMaterialParam(_Material *material, const char *name, const void *value, uint32_t size, uint32_t components, bool integer)
+{
+    for (const UniformMember &member : material->program->params)
+    {
+        if (member.name != name)
+            continue;
+
+        if (member.components != components || member.integer != integer || member.size < size)
+        {
+            printf("Material parameter %s has a different type\n", name);
+            return;
+        }
+
+        memcpy(material->params + member.offset, value, size);
+        return;
+    }
+
+    printf("Material has no parameter named %s\n", name);
+}
+
+void SetMaterialFloat(Material *material, const char *name, float value)
+{
+    SetMaterialParam((_Material *)material, name, &value, sizeof(value), 1, false);
+}
+
+void SetMaterialVec2(Material *material, const char *name, glm::vec2 value)
+{
+    SetMaterialParam((_Material *)material, name, &value, sizeof(value), 2, false);
+}
+
+void SetMaterialVec3(Material *material, const char *name, glm::vec3 value)
+{
+    SetMaterialParam((_Material *)material, name, &value, sizeof(value), 3, false);
+}
+
+void SetMaterialVec4(Material *material, const char *name, glm::vec4 value)
+{
+    SetMaterialParam((_Material *)material, name, &value, sizeof(value), 4, false);
+}
+
+void SetMaterialInt(Material *material, const char *name, int32_t value)
+{
+    SetMaterialParam((_Material *)material, name, &value, sizeof(value), 1, true);
+}
\ No newline at end of file
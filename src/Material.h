@@ -0,0 +1,44 @@
+#pragma once
+
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+#include "GraphicsPipeline.h"
+#include "Shader.h"
+
+struct FrameResources;
+
+#define MATERIAL_PARAMS_SET 2
+#define MATERIAL_PARAMS_SIZE 256            // Every draw takes this much of the ring, so the dynamic range is always in bounds
+#define MATERIAL_RING_SIZE (64 * 1024)
+
+// Shared by every material created from the same sources and defines
+struct MaterialProgram
+{
+    uint64_t key;
+    uint32_t refCount;
+
+    GraphicsPipeline pipeline;
+
+    std::vector<UniformMember> params;      // Members of the parameter block
+    uint32_t paramsSize;
+};
+
+struct _Material
+{
+    MaterialProgram *program;
+
+    uint8_t params[MATERIAL_PARAMS_SIZE];
+};
+
+// The parameter set of each frame points at that frame's ring, draws only pick a dynamic offset
+void InitFrameMaterialParams(FrameResources &frame);
+void DestroyFrameMaterialParams(FrameResources &frame);
+
+// Called once the frame's fence has been waited on, a ring that overflowed last time is doubled
+void ResetFrameMaterialParams(FrameResources &frame);
+
+void InitMaterials();
+void ShutdownMaterials();
\ No newline at end of file
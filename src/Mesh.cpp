@@ -0,0 +1,39 @@
+#include "Renderer.h"
+
+#include "Internal.h"
+#include "Buffer.h"
+
+Mesh *CreateMesh(const glm::vec2 *vertices, uint32_t vertexCount, const uint16_t *indices /* = nullptr */, uint32_t indexCount /* = 0 */)
+{
+    if (vertexCount == 0 || vertexCount > 65536)
+    {
+        printf("Mesh vertex count %u is outside 1 to 65536\n", vertexCount);
+        return nullptr;
+    }
+
+    _Mesh *mesh = new _Mesh();
+    mesh->vertexCount = vertexCount;
+    mesh->indexCount = indices ? indexCount : 0;
+
+    CreateStaticBuffer(&mesh->vertexBuffer, vertices, vertexCount * sizeof(glm::vec2), VK_BUFFER_USAGE_VERTEX_BUFFER_BIT);
+
+    if (mesh->indexCount > 0)
+        CreateStaticBuffer(&mesh->indexBuffer, indices, indexCount * sizeof(uint16_t), VK_BUFFER_USAGE_INDEX_BUFFER_BIT);
+
+    return (Mesh *)mesh;
+}
+
+void DestroyMesh(Mesh *handle)
+{
+    _Mesh *mesh = (_Mesh *)handle;
+
+    // Earlier frames may still be drawing with it
+    AcquireCurrentFrame().deletionQueue.push_back([=]()
+    {
+        if (mesh->indexCount > 0)
+            DestroyBuffer(&mesh->indexBuffer);
+
+        DestroyBuffer(&mesh->vertexBuffer);
+        delete mesh;
+    });
+}
\ No newline at end of file
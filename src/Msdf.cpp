@@ -0,0 +1,454 @@
+#include "Msdf.h"
+
+#include <math.h>
+#include <float.h>
+
+#include <vector>
+
+// Consecutive edges meeting at an angle whose sine is above this, or turning back, form a corner
+#define CORNER_THRESHOLD 0.14112f     // sin(3)
+
+#define CHANNEL_RED 1
+#define CHANNEL_GREEN 2
+#define CHANNEL_BLUE 4
+
+#define COLOR_CYAN (CHANNEL_GREEN | CHANNEL_BLUE)
+#define COLOR_MAGENTA (CHANNEL_RED | CHANNEL_BLUE)
+#define COLOR_YELLOW (CHANNEL_RED | CHANNEL_GREEN)
+#define COLOR_WHITE (CHANNEL_RED | CHANNEL_GREEN | CHANNEL_BLUE)
+
+// An edge in output pixels, lines have their control point in the middle
+struct ColoredEdge
+{
+    glm::dvec2 p0;
+    glm::dvec2 control;
+    glm::dvec2 p1;
+
+    bool curved;
+    uint32_t color;
+};
+
+// Ordered by distance first and then by how much the point lies off the end of the edge, so of two edges
+// sharing a corner the one the point is really next to wins
+struct SignedDistance
+{
+    double distance;
+    double dot;
+};
+
+static inline bool operator<(const SignedDistance &a, const SignedDistance &b)
+{
+    return fabs(a.distance) < fabs(b.distance) || (fabs(a.distance) == fabs(b.distance) && a.dot < b.dot);
+}
+
+static inline double Cross(glm::dvec2 a, glm::dvec2 b)
+{
+    return a.x * b.y - a.y * b.x;
+}
+
+static inline double NonZeroSign(double value)
+{
+    return value > 0.0 ? 1.0 : -1.0;
+}
+
+static glm::dvec2 SafeNormalize(glm::dvec2 v)
+{
+    double length = glm::length(v);
+    return length > 0.0 ? v / length : glm::dvec2(0.0);
+}
+
+static glm::dvec2 GetDirection(const ColoredEdge &edge, double t)
+{
+    if (!edge.curved)
+        return edge.p1 - edge.p0;
+
+    glm::dvec2 direction = glm::mix(edge.control - edge.p0, edge.p1 - edge.control, t);
+
+    // Degenerate when the control point sits on an end point
+    if (direction == glm::dvec2(0.0))
+        return edge.p1 - edge.p0;
+
+    return direction;
+}
+
+static glm::dvec2 GetPoint(const ColoredEdge &edge, double t)
+{
+    double u = 1.0 - t;
+    return edge.p0 * (u * u) + edge.control * (2.0 * u * t) + edge.p1 * (t * t);
+}
+
+static int SolveQuadratic(double roots[2], double a, double b, double c)
+{
+    if (fabs(a) < 1e-14)
+    {
+        if (fabs(b) < 1e-14)
+            return 0;
+
+        roots[0] = -c / b;
+        return 1;
+    }
+
+    double discriminant = b * b - 4.0 * a * c;
+    if (discriminant > 0.0)
+    {
+        discriminant = sqrt(discriminant);
+        roots[0] = (-b + discriminant) / (2.0 * a);
+        roots[1] = (-b - discriminant) / (2.0 * a);
+        return 2;
+    }
+
+    if (discriminant == 0.0)
+    {
+        roots[0] = -b / (2.0 * a);
+        return 1;
+    }
+
+    return 0;
+}
+
+// x^3 + a x^2 + b x + c
+static int SolveCubicNormed(double roots[3], double a, double b, double c)
+{
+    double a2 = a * a;
+    double q = (a2 - 3.0 * b) / 9.0;
+    double r = (a * (2.0 * a2 - 9.0 * b) + 27.0 * c) / 54.0;
+    double r2 = r * r;
+    double q3 = q * q * q;
+
+    if (r2 < q3)
+    {
+        double t = r / sqrt(q3);
+        t = acos(t < -1.0 ? -1.0 : t > 1.0 ? 1.0 : t);
+
+        a /= 3.0;
+        q = -2.0 * sqrt(q);
+
+        roots[0] = q * cos(t / 3.0) - a;
+        roots[1] = q * cos((t + 2.0 * M_PI) / 3.0) - a;
+        roots[2] = q * cos((t - 2.0 * M_PI) / 3.0) - a;
+        return 3;
+    }
+
+    double A = -pow(fabs(r) + sqrt(r2 - q3), 1.0 / 3.0);
+    if (r < 0.0)
+        A = -A;
+
+    double B = A == 0.0 ? 0.0 : q / A;
+    a /= 3.0;
+
+    roots[0] = (A + B) - a;
+    roots[1] = -0.5 * (A + B) - a;
+
+    return fabs(0.5 * sqrt(3.0) * (A - B)) < 1e-14 ? 2 : 1;
+}
+
+static int SolveCubic(double roots[3], double a, double b, double c, double d)
+{
+    if (a != 0.0)
+    {
+        double bn = b / a;
+
+        // Nearly quadratic otherwise, where the normed form loses all precision
+        if (fabs(bn) < 1e6)
+            return SolveCubicNormed(roots, bn, c / a, d / a);
+    }
+
+    return SolveQuadratic(roots, b, c, d);
+}
+
+// Distance from p to the edge and the parameter of the closest point, which lies outside [0, 1] when
+// the closest point is an end point and p is beyond it
+static SignedDistance GetEdgeDistance(const ColoredEdge &edge, glm::dvec2 p, double *param)
+{
+    if (!edge.curved)
+    {
+        glm::dvec2 aq = p - edge.p0;
+        glm::dvec2 ab = edge.p1 - edge.p0;
+
+        *param = glm::dot(aq, ab) / glm::dot(ab, ab);
+
+        glm::dvec2 eq = (*param > 0.5 ? edge.p1 : edge.p0) - p;
+        double endpointDistance = glm::length(eq);
+
+        if (*param > 0.0 && *param < 1.0)
+        {
+            double orthoDistance = Cross(aq, ab) / glm::length(ab);
+            if (fabs(orthoDistance) < endpointDistance)
+                return { orthoDistance, 0.0 };
+        }
+
+        return { NonZeroSign(Cross(aq, ab)) * endpointDistance, fabs(glm::dot(SafeNormalize(ab), SafeNormalize(eq))) };
+    }
+
+    glm::dvec2 qa = edge.p0 - p;
+    glm::dvec2 ab = edge.control - edge.p0;
+    glm::dvec2 br = edge.p1 - edge.control - ab;
+
+    double a = glm::dot(br, br);
+    double b = 3.0 * glm::dot(ab, br);
+    double c = 2.0 * glm::dot(ab, ab) + glm::dot(qa, br);
+    double d = glm::dot(qa, ab);
+
+    glm::dvec2 direction = GetDirection(edge, 0.0);
+    double minDistance = NonZeroSign(Cross(direction, qa)) * glm::length(qa);
+    *param = -glm::dot(qa, direction) / glm::dot(direction, direction);
+
+    double distance = glm::length(edge.p1 - p);
+    if (distance < fabs(minDistance))
+    {
+        direction = GetDirection(edge, 1.0);
+        minDistance = NonZeroSign(Cross(direction, edge.p1 - p)) * distance;
+        *param = glm::dot(p - edge.control, direction) / glm::dot(direction, direction);
+    }
+
+    double roots[3];
+    int rootCount = SolveCubic(roots, a, b, c, d);
+
+    for (int i = 0; i < rootCount; ++i)
+    {
+        double t = roots[i];
+        if (t <= 0.0 || t >= 1.0)
+            continue;
+
+        glm::dvec2 qe = qa + ab * (2.0 * t) + br * (t * t);
+        distance = glm::length(qe);
+
+        if (distance <= fabs(minDistance))
+        {
+            minDistance = NonZeroSign(Cross(ab + br * t, qe)) * distance;
+            *param = t;
+        }
+    }
+
+    if (*param >= 0.0 && *param <= 1.0)
+        return { minDistance, 0.0 };
+
+    if (*param < 0.5)
+        return { minDistance, fabs(glm::dot(SafeNormalize(GetDirection(edge, 0.0)), SafeNormalize(qa))) };
+
+    return { minDistance, fabs(glm::dot(SafeNormalize(GetDirection(edge, 1.0)), SafeNormalize(edge.p1 - p))) };
+}
+
+// Past the ends of the closest edge its tangent is extended, so the channels stay straight through a
+// corner instead of rounding off around it
+static double GetPseudoDistance(const ColoredEdge &edge, glm::dvec2 p, double param, SignedDistance distance)
+{
+    if (param < 0.0)
+    {
+        glm::dvec2 direction = SafeNormalize(GetDirection(edge, 0.0));
+        glm::dvec2 aq = p - edge.p0;
+
+        if (glm::dot(aq, direction) < 0.0)
+        {
+            double pseudo = Cross(aq, direction);
+            if (fabs(pseudo) <= fabs(distance.distance))
+                return pseudo;
+        }
+    }
+    else if (param > 1.0)
+    {
+        glm::dvec2 direction = SafeNormalize(GetDirection(edge, 1.0));
+        glm::dvec2 bq = p - edge.p1;
+
+        if (glm::dot(bq, direction) > 0.0)
+        {
+            double pseudo = Cross(bq, direction);
+            if (fabs(pseudo) <= fabs(distance.distance))
+                return pseudo;
+        }
+    }
+
+    return distance.distance;
+}
+
+static bool IsCorner(glm::dvec2 a, glm::dvec2 b)
+{
+    a = SafeNormalize(a);
+    b = SafeNormalize(b);
+
+    return glm::dot(a, b) <= 0.0 || fabs(Cross(a, b)) > CORNER_THRESHOLD;
+}
+
+// Thirds of the edge, so a contour with a single corner has enough edges for three colors
+static void SplitEdgeInThirds(const ColoredEdge &edge, ColoredEdge parts[3])
+{
+    for (int i = 0; i < 3; ++i)
+    {
+        double t0 = i / 3.0;
+        double t1 = (i + 1) / 3.0;
+
+        ColoredEdge &part = parts[i];
+        part.p0 = GetPoint(edge, t0);
+        part.p1 = GetPoint(edge, t1);
+        part.curved = edge.curved;
+        part.color = edge.color;
+
+        // The control point of a sub-curve lies where the tangents at its ends cross
+        glm::dvec2 c0 = glm::mix(edge.p0, edge.control, t0);
+        glm::dvec2 c1 = glm::mix(edge.control, edge.p1, t0);
+        part.control = edge.curved ? glm::mix(c0, c1, t1) : (part.p0 + part.p1) * 0.5;
+    }
+}
+
+static void ColorContour(std::vector<ColoredEdge> &edges, uint32_t first, uint32_t end)
+{
+    uint32_t count = end - first;
+
+    std::vector<uint32_t> corners;
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        const ColoredEdge &previous = edges[first + (i + count - 1) % count];
+        const ColoredEdge &current = edges[first + i];
+
+        if (IsCorner(GetDirection(previous, 1.0), GetDirection(current, 0.0)))
+            corners.push_back(i);
+    }
+
+    // Smooth contours need no corners reconstructed
+    if (corners.empty())
+    {
+        for (uint32_t i = first; i < end; ++i)
+        {
+            edges[i].color = COLOR_WHITE;
+        }
+
+        return;
+    }
+
+    // A teardrop, the single corner is split between the first and last third
+    if (corners.size() == 1)
+    {
+        if (count < 3)
+        {
+            std::vector<ColoredEdge> split;
+            for (uint32_t i = 0; i < count; ++i)
+            {
+                ColoredEdge parts[3];
+                SplitEdgeInThirds(edges[first + (corners[0] + i) % count], parts);
+                split.insert(split.end(), parts, parts + 3);
+            }
+
+            for (uint32_t i = 0; i < count; ++i)
+            {
+                edges.erase(edges.begin() + first);
+            }
+
+            edges.insert(edges.begin() + first, split.begin(), split.end());
+
+            count = (uint32_t)split.size();
+            corners[0] = 0;
+        }
+
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            uint32_t third = i * 3 / count;
+            uint32_t color = third == 0 ? COLOR_MAGENTA : third == 1 ? COLOR_WHITE : COLOR_YELLOW;
+
+            edges[first + (corners[0] + i) % count].color = color;
+        }
+
+        return;
+    }
+
+    // Runs between corners cycle through three colors, each pair sharing one channel. When the last
+    // run would meet the first with the same color it takes the third one.
+    static const uint32_t colors[] = { COLOR_CYAN, COLOR_MAGENTA, COLOR_YELLOW };
+
+    uint32_t runCount = (uint32_t)corners.size();
+    uint32_t run = 0;
+
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        uint32_t index = (corners[0] + i) % count;
+        if (run + 1 < runCount && index == corners[run + 1])
+            ++run;
+
+        uint32_t color = colors[run % 3];
+        if (run == runCount - 1 && runCount % 3 == 1)
+            color = COLOR_MAGENTA;
+
+        edges[first + index].color = color;
+    }
+}
+
+static uint8_t EncodeDistance(double distance, double range)
+{
+    double value = 0.5 + distance / (2.0 * range);
+    value = value < 0.0 ? 0.0 : value > 1.0 ? 1.0 : value;
+
+    return (uint8_t)(value * 255.0 + 0.5);
+}
+
+void GenerateMsdf(const GlyphOutline &outline, float scale, glm::vec2 offset, float range, uint8_t *pixels, uint32_t width, uint32_t height, uint32_t stride)
+{
+    // Flipping y mirrors the outline, which also flips which side of each edge is inside
+    std::vector<ColoredEdge> edges;
+    edges.reserve(outline.edges.size());
+
+    for (const OutlineEdge &source : outline.edges)
+    {
+        ColoredEdge edge;
+        edge.p0 = { source.p0.x * scale + offset.x, offset.y - source.p0.y * scale };
+        edge.control = { source.control.x * scale + offset.x, offset.y - source.control.y * scale };
+        edge.p1 = { source.p1.x * scale + offset.x, offset.y - source.p1.y * scale };
+        edge.curved = source.curved;
+        edge.color = COLOR_WHITE;
+
+        edges.push_back(edge);
+    }
+
+    // Contours are recolored back to front, splitting one shifts only the edges after it
+    for (uint32_t i = (uint32_t)outline.contourEnds.size(); i > 0; --i)
+    {
+        uint32_t first = i > 1 ? outline.contourEnds[i - 2] : 0;
+        ColorContour(edges, first, outline.contourEnds[i - 1]);
+    }
+
+    for (uint32_t y = 0; y < height; ++y)
+    {
+        uint8_t *row = pixels + y * stride;
+
+        for (uint32_t x = 0; x < width; ++x)
+        {
+            glm::dvec2 p = { x + 0.5, y + 0.5 };
+
+            SignedDistance closest[3];
+            const ColoredEdge *closestEdge[3] = {};
+            double closestParam[3] = {};
+
+            SignedDistance trueClosest = { -DBL_MAX, 1.0 };
+
+            for (int c = 0; c < 3; ++c)
+            {
+                closest[c] = { -DBL_MAX, 1.0 };
+            }
+
+            for (const ColoredEdge &edge : edges)
+            {
+                double param;
+                SignedDistance distance = GetEdgeDistance(edge, p, &param);
+
+                if (distance < trueClosest)
+                    trueClosest = distance;
+
+                for (int c = 0; c < 3; ++c)
+                {
+                    if ((edge.color & (1 << c)) && distance < closest[c])
+                    {
+                        closest[c] = distance;
+                        closestEdge[c] = &edge;
+                        closestParam[c] = param;
+                    }
+                }
+            }
+
+            for (int c = 0; c < 3; ++c)
+            {
+                double distance = closestEdge[c] ? GetPseudoDistance(*closestEdge[c], p, closestParam[c], closest[c]) : -DBL_MAX;
+                row[x * 4 + c] = EncodeDistance(-distance, range);
+            }
+
+            row[x * 4 + 3] = EncodeDistance(-trueClosest.distance, range);
+        }
+    }
+}
\ No newline at end of file
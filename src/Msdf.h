@@ -0,0 +1,17 @@
+#pragma once
+
+#include <stdint.h>
+
+#include <glm/glm.hpp>
+
+#include "TrueType.h"
+
+// Multi-channel signed distance fields of glyph outlines. Each contour is split into runs of edges at
+// its corners and the runs are given channel masks that differ at every corner, so the median of the
+// three channels reconstructs sharp corners when magnified. Alpha holds the true distance, which stays
+// smooth away from the outline where the median breaks down.
+//
+// A point lands on pixel (x * scale + offset.x, offset.y - y * scale), so the first row is the top. Distances
+// are in output pixels, positive inside, and stored as 0.5 + d / (2 * range), so only distances within
+// range of the outline are kept. stride is in bytes. Safe to call from several threads at once.
+void GenerateMsdf(const GlyphOutline &outline, float scale, glm::vec2 offset, float range, uint8_t *pixels, uint32_t width, uint32_t height, uint32_t stride);
\ No newline at end of file
@@ -0,0 +1,330 @@
+#include "Path.h"
+
+#include <math.h>
+#include <stdio.h>
+
+// Arcs of round joins and caps stray at most this far from the true circle, in pixels
+#define ROUND_TOLERANCE 0.25f
+#define PI 3.14159265358979f
+
+// Squared distance below which consecutive points are merged
+#define POINT_EPSILON 1e-8f
+
+static inline float Cross(glm::vec2 a, glm::vec2 b)
+{
+    return a.x * b.y - a.y * b.x;
+}
+
+static inline glm::vec2 Perpendicular(glm::vec2 d)
+{
+    return { -d.y, d.x };
+}
+
+static uint32_t AddVertex(PathGeometry *geometry, glm::vec2 vertex)
+{
+    geometry->vertices.push_back(vertex);
+    return (uint32_t)geometry->vertices.size() - 1;
+}
+
+static void AddTriangle(PathGeometry *geometry, uint32_t a, uint32_t b, uint32_t c)
+{
+    geometry->indices.push_back(a);
+    geometry->indices.push_back(b);
+    geometry->indices.push_back(c);
+}
+
+// Fan around center, starting at the unit direction from and sweeping angle radians, negative sweeps go clockwise
+static void AddArc(PathGeometry *geometry, glm::vec2 center, glm::vec2 from, float angle, float radius)
+{
+    float step = radius > ROUND_TOLERANCE ? 2.0f * acosf(1.0f - ROUND_TOLERANCE / radius) : PI * 0.5f;
+    uint32_t steps = (uint32_t)ceilf(fabsf(angle) / step);
+    if (steps == 0)
+        steps = 1;
+
+    uint32_t c = AddVertex(geometry, center);
+    uint32_t previous = AddVertex(geometry, center + from * radius);
+
+    for (uint32_t i = 1; i <= steps; ++i)
+    {
+        float a = angle * (float)i / (float)steps;
+        float cs = cosf(a);
+        float sn = sinf(a);
+
+        glm::vec2 direction = { from.x * cs - from.y * sn, from.x * sn + from.y * cs };
+        uint32_t current = AddVertex(geometry, center + direction * radius);
+
+        if (angle > 0.0f)
+            AddTriangle(geometry, c, previous, current);
+        else
+            AddTriangle(geometry, c, current, previous);
+
+        previous = current;
+    }
+}
+
+// Drops repeated points, they have no direction. A closing point equal to the first is dropped as well.
+static void RemoveDuplicatePoints(std::vector<glm::vec2> *path, const glm::vec2 *points, uint32_t count)
+{
+    path->reserve(count);
+
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        if (path->empty())
+        {
+            path->push_back(points[i]);
+            continue;
+        }
+
+        glm::vec2 delta = points[i] - path->back();
+        if (glm::dot(delta, delta) > POINT_EPSILON)
+            path->push_back(points[i]);
+    }
+
+    if (path->size() > 2)
+    {
+        glm::vec2 delta = path->front() - path->back();
+        if (glm::dot(delta, delta) <= POINT_EPSILON)
+            path->pop_back();
+    }
+}
+
+static void AddJoin(PathGeometry *geometry, glm::vec2 previous, glm::vec2 point, glm::vec2 next, float half, const PolylineStyle &style)
+{
+    glm::vec2 d0 = glm::normalize(point - previous);
+    glm::vec2 d1 = glm::normalize(next - point);
+
+    float turn = Cross(d0, d1);
+    if (fabsf(turn) < 1e-6f && glm::dot(d0, d1) > 0.0f)
+        return;
+
+    // The gap opens on the outside of the bend
+    float side = turn > 0.0f ? -1.0f : 1.0f;
+    glm::vec2 n0 = Perpendicular(d0) * side;
+    glm::vec2 n1 = Perpendicular(d1) * side;
+
+    if (style.join == LineJoinRound)
+    {
+        AddArc(geometry, point, n0, atan2f(Cross(n0, n1), glm::dot(n0, n1)), half);
+        return;
+    }
+
+    if (style.join == LineJoinMiter)
+    {
+        glm::vec2 miter = n0 + n1;
+        float length = glm::length(miter);
+
+        if (length > 1e-6f)
+        {
+            miter /= length;
+
+            float reach = half / glm::dot(miter, n0);
+            if (reach <= style.miterLimit * half)
+            {
+                uint32_t c = AddVertex(geometry, point);
+                uint32_t a = AddVertex(geometry, point + n0 * half);
+                uint32_t tip = AddVertex(geometry, point + miter * reach);
+                uint32_t b = AddVertex(geometry, point + n1 * half);
+
+                if (turn > 0.0f)
+                {
+                    AddTriangle(geometry, c, a, tip);
+                    AddTriangle(geometry, c, tip, b);
+                }
+                else
+                {
+                    AddTriangle(geometry, c, tip, a);
+                    AddTriangle(geometry, c, b, tip);
+                }
+
+                return;
+            }
+        }
+    }
+
+    uint32_t c = AddVertex(geometry, point);
+    uint32_t a = AddVertex(geometry, point + n0 * half);
+    uint32_t b = AddVertex(geometry, point + n1 * half);
+
+    if (turn > 0.0f)
+        AddTriangle(geometry, c, a, b);
+    else
+        AddTriangle(geometry, c, b, a);
+}
+
+void TessellatePolyline(PathGeometry *geometry, const glm::vec2 *points, uint32_t count, const PolylineStyle &style)
+{
+    std::vector<glm::vec2> path;
+    RemoveDuplicatePoints(&path, points, count);
+
+    uint32_t pointCount = (uint32_t)path.size();
+    if (pointCount < 2 || style.width <= 0.0f)
+        return;
+
+    bool closed = style.closed && pointCount > 2;
+    uint32_t segmentCount = closed ? pointCount : pointCount - 1;
+
+    float half = style.width * 0.5f;
+
+    geometry->vertices.reserve(geometry->vertices.size() + segmentCount * 8);
+    geometry->indices.reserve(geometry->indices.size() + segmentCount * 12);
+
+    for (uint32_t s = 0; s < segmentCount; ++s)
+    {
+        glm::vec2 a = path[s];
+        glm::vec2 b = path[(s + 1) % pointCount];
+
+        glm::vec2 d = glm::normalize(b - a);
+        glm::vec2 n = Perpendicular(d) * half;
+
+        if (!closed && style.cap == LineCapSquare)
+        {
+            if (s == 0)
+                a -= d * half;
+            if (s == segmentCount - 1)
+                b += d * half;
+        }
+
+        uint32_t i0 = AddVertex(geometry, a + n);
+        uint32_t i1 = AddVertex(geometry, b + n);
+        uint32_t i2 = AddVertex(geometry, b - n);
+        uint32_t i3 = AddVertex(geometry, a - n);
+
+        AddTriangle(geometry, i0, i2, i1);
+        AddTriangle(geometry, i2, i0, i3);
+    }
+
+    uint32_t first = closed ? 0 : 1;
+    uint32_t last = closed ? pointCount : pointCount - 1;
+
+    for (uint32_t j = first; j < last; ++j)
+    {
+        AddJoin(geometry, path[(j + pointCount - 1) % pointCount], path[j], path[(j + 1) % pointCount], half, style);
+    }
+
+    if (!closed && style.cap == LineCapRound)
+    {
+        glm::vec2 start = glm::normalize(path[1] - path[0]);
+        glm::vec2 end = glm::normalize(path[pointCount - 1] - path[pointCount - 2]);
+
+        // Half circles behind the first point and past the last one
+        AddArc(geometry, path[0], Perpendicular(start), PI, half);
+        AddArc(geometry, path[pointCount - 1], -Perpendicular(end), PI, half);
+    }
+}
+
+static bool IsPointInTriangle(glm::vec2 p, glm::vec2 a, glm::vec2 b, glm::vec2 c)
+{
+    return Cross(b - a, p - a) >= 0.0f && Cross(c - b, p - b) >= 0.0f && Cross(a - c, p - c) >= 0.0f;
+}
+
+// ring is counter-clockwise, so an ear is a convex corner with no other vertex inside it
+static bool IsEar(const std::vector<glm::vec2> &polygon, const std::vector<uint32_t> &ring, uint32_t i)
+{
+    uint32_t size = (uint32_t)ring.size();
+
+    glm::vec2 a = polygon[ring[(i + size - 1) % size]];
+    glm::vec2 b = polygon[ring[i]];
+    glm::vec2 c = polygon[ring[(i + 1) % size]];
+
+    if (Cross(b - a, c - b) <= 0.0f)
+        return false;
+
+    for (uint32_t j = 0; j < size; ++j)
+    {
+        glm::vec2 p = polygon[ring[j]];
+        if (p == a || p == b || p == c)
+            continue;
+
+        if (IsPointInTriangle(p, a, b, c))
+            return false;
+    }
+
+    return true;
+}
+
+bool TessellatePolygon(PathGeometry *geometry, const glm::vec2 *points, uint32_t count)
+{
+    std::vector<glm::vec2> polygon;
+    RemoveDuplicatePoints(&polygon, points, count);
+
+    uint32_t size = (uint32_t)polygon.size();
+    if (size < 3)
+        return false;
+
+    float area = 0.0f;
+    for (uint32_t i = 0; i < size; ++i)
+    {
+        area += Cross(polygon[i], polygon[(i + 1) % size]);
+    }
+
+    std::vector<uint32_t> ring(size);
+    for (uint32_t i = 0; i < size; ++i)
+    {
+        ring[i] = area > 0.0f ? i : size - 1 - i;
+    }
+
+    uint32_t base = (uint32_t)geometry->vertices.size();
+    geometry->vertices.insert(geometry->vertices.end(), polygon.begin(), polygon.end());
+    geometry->indices.reserve(geometry->indices.size() + (size - 2) * 3);
+
+    uint32_t i = 0;
+    uint32_t attempts = 0;
+
+    while (ring.size() > 3)
+    {
+        uint32_t remaining = (uint32_t)ring.size();
+        i %= remaining;
+
+        // A full lap without an ear means degenerate or self intersecting input, clipping anyway still ends the loop
+        if (IsEar(polygon, ring, i) || attempts >= remaining)
+        {
+            AddTriangle(geometry, base + ring[(i + remaining - 1) % remaining], base + ring[i], base + ring[(i + 1) % remaining]);
+            ring.erase(ring.begin() + i);
+
+            attempts = 0;
+        }
+        else
+        {
+            ++i;
+            ++attempts;
+        }
+    }
+
+    AddTriangle(geometry, base + ring[0], base + ring[1], base + ring[2]);
+
+    return true;
+}
+
+PathMesh *CreatePolylineMesh(const glm::vec2 *points, uint32_t count, const PolylineStyle &style /* = {} */)
+{
+    _PathMesh *mesh = new _PathMesh();
+    TessellatePolyline(&mesh->geometry, points, count, style);
+
+    if (mesh->geometry.indices.empty())
+    {
+        printf("Polyline needs at least 2 distinct points and a positive width, got %u points\n", count);
+        delete mesh;
+        return nullptr;
+    }
+
+    return (PathMesh *)mesh;
+}
+
+PathMesh *CreatePolygonMesh(const glm::vec2 *points, uint32_t count)
+{
+    _PathMesh *mesh = new _PathMesh();
+    if (!TessellatePolygon(&mesh->geometry, points, count))
+    {
+        printf("Polygon needs at least 3 distinct points, got %u\n", count);
+        delete mesh;
+        return nullptr;
+    }
+
+    return (PathMesh *)mesh;
+}
+
+void DestroyPathMesh(PathMesh *handle)
+{
+    // Only CPU side triangles, what was drawn from them was copied into the frame's rings
+    delete (_PathMesh *)handle;
+}
\ No newline at end of file
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <stdint.h>
+
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "Renderer.h"
+
+// Triangle lists produced by the tessellators, indices refer to vertices of the same path
+struct PathGeometry
+{
+    std::vector<glm::vec2> vertices;
+    std::vector<uint32_t> indices;
+};
+
+struct _PathMesh
+{
+    PathGeometry geometry;
+};
+
+// Appends to geometry. Each segment is its own quad and joins fill the gap on the outer side of a bend,
+// so translucent strokes blend twice where segments overlap on the inner side.
+void TessellatePolyline(PathGeometry *geometry, const glm::vec2 *points, uint32_t count, const PolylineStyle &style);
+
+// Ear clipping, accepts concave outlines in either winding without holes. Appends nothing and returns
+// false when fewer than three distinct points remain. Self intersecting input still produces triangles,
+// but they may overlap.
+bool TessellatePolygon(PathGeometry *geometry, const glm::vec2 *points, uint32_t count);
\ No newline at end of file
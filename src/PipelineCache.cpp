@@ -0,0 +1,175 @@
+#include "PipelineCache.h"
+
+#include "Renderer.h"
+#include "Internal.h"
+#include "Utils.h"
+#include "Hash.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <fstream>
+#include <mutex>
+#include <thread>
+
+#define PIPELINE_CACHE_PATH "pipeline.cache"
+
+struct PipelineCacheState
+{
+    std::mutex saveMutex;
+    uint64_t savedHash;     // Of the data last loaded or saved
+
+    std::thread autosaveThread;
+    std::mutex autosaveMutex;
+    std::condition_variable autosaveWake;
+    uint32_t autosaveSeconds;
+};
+
+static PipelineCacheState state;
+
+// Data from another driver, device or driver version is useless, and some drivers crash on it
+static bool IsPipelineCacheDataValid(const std::vector<char> &data)
+{
+    if (data.size() < sizeof(VkPipelineCacheHeaderVersionOne))
+        return false;
+
+    VkPipelineCacheHeaderVersionOne header;
+    memcpy(&header, data.data(), sizeof(header));
+
+    VkPhysicalDeviceProperties properties = {};
+    vkGetPhysicalDeviceProperties(renderer.physicalDevice, &properties);
+
+    return header.headerSize >= sizeof(VkPipelineCacheHeaderVersionOne) &&
+        header.headerVersion == VK_PIPELINE_CACHE_HEADER_VERSION_ONE &&
+        header.vendorID == properties.vendorID &&
+        header.deviceID == properties.deviceID &&
+        memcmp(header.pipelineCacheUUID, properties.pipelineCacheUUID, VK_UUID_SIZE) == 0;
+}
+
+void CreatePipelineCache()
+{
+    std::vector<char> data;
+
+    std::ifstream file(PIPELINE_CACHE_PATH, std::ios::binary);
+    if (file.is_open())
+    {
+        data.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+
+        if (!IsPipelineCacheDataValid(data))
+        {
+            printf("Discarding stale pipeline cache: %s\n", PIPELINE_CACHE_PATH);
+            data.clear();
+        }
+    }
+
+    VkPipelineCacheCreateInfo cacheInfo = {};
+    cacheInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+    cacheInfo.pNext = nullptr;
+    cacheInfo.flags = 0;
+    cacheInfo.initialDataSize = data.size();
+    cacheInfo.pInitialData = data.empty() ? nullptr : data.data();
+
+    VkCheck(vkCreatePipelineCache(renderer.device, &cacheInfo, nullptr, &renderer.cache));
+
+    state.savedHash = HashMemory(data.data(), data.size());
+}
+
+static void StopAutosave()
+{
+    if (!state.autosaveThread.joinable())
+        return;
+
+    {
+        std::lock_guard<std::mutex> lock(state.autosaveMutex);
+        state.autosaveSeconds = 0;
+    }
+
+    state.autosaveWake.notify_all();
+    state.autosaveThread.join();
+}
+
+void DestroyPipelineCache()
+{
+    StopAutosave();
+    SavePipelineCache();
+
+    vkDestroyPipelineCache(renderer.device, renderer.cache, nullptr);
+    renderer.cache = VK_NULL_HANDLE;
+}
+
+// Pipeline caches are internally synchronized, so this is safe alongside pipeline creation
+void SavePipelineCache()
+{
+    std::lock_guard<std::mutex> lock(state.saveMutex);
+
+    // Pipelines created between the size query and the copy grow the cache, which makes the copy return
+    // VK_INCOMPLETE, so the size is queried again until they agree. Results are checked here rather than
+    // through VkCheck, which breaks and writes renderer.result, since this also runs on the autosave thread.
+    std::vector<char> data;
+    size_t size = 0;
+    VkResult result;
+    do
+    {
+        result = vkGetPipelineCacheData(renderer.device, renderer.cache, &size, nullptr);
+        if (result != VK_SUCCESS)
+            break;
+
+        data.resize(size);
+        result = vkGetPipelineCacheData(renderer.device, renderer.cache, &size, data.data());
+    } while (result == VK_INCOMPLETE);
+
+    if (result != VK_SUCCESS)
+    {
+        printf("Failed to read pipeline cache data: %s\n", GetVkResultString(result));
+        return;
+    }
+
+    // Drivers may replace entries without the size changing, so the contents are compared
+    uint64_t hash = HashMemory(data.data(), size);
+    if (hash == state.savedHash)
+        return;
+
+    std::string tempPath = PIPELINE_CACHE_PATH ".tmp";
+
+    {
+        std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+        if (!file.is_open())
+        {
+            printf("Failed to write pipeline cache: %s\n", tempPath.c_str());
+            return;
+        }
+
+        file.write(data.data(), size);
+    }
+
+    if (!PlatformReplaceFile(tempPath.c_str(), PIPELINE_CACHE_PATH))
+    {
+        printf("Failed to write pipeline cache: %s\n", PIPELINE_CACHE_PATH);
+        return;
+    }
+
+    state.savedHash = hash;
+}
+
+void SetPipelineCacheAutosave(uint32_t seconds)
+{
+    StopAutosave();
+
+    if (seconds == 0)
+        return;
+
+    state.autosaveSeconds = seconds;
+    state.autosaveThread = std::thread([]()
+    {
+        std::unique_lock<std::mutex> lock(state.autosaveMutex);
+
+        while (state.autosaveSeconds != 0)
+        {
+            if (state.autosaveWake.wait_for(lock, std::chrono::seconds(state.autosaveSeconds), []() { return state.autosaveSeconds == 0; }))
+                break;
+
+            lock.unlock();
+            SavePipelineCache();
+            lock.lock();
+        }
+    });
+}
\ No newline at end of file
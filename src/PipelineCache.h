@@ -0,0 +1,8 @@
+#pragma once
+
+// renderer.cache is seeded from the previous run's data and written back at shutdown, so warm
+// starts skip the driver's pipeline compilation
+void CreatePipelineCache();
+void DestroyPipelineCache();
+
+void SavePipelineCache();
\ No newline at end of file
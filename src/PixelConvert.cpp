@@ -0,0 +1,380 @@
+#include "PixelConvert.h"
+
+#include "JobSystem.h"
+
+#include <math.h>
+#include <string.h>
+#include <assert.h>
+
+#include <vector>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define PIXEL_CONVERT_X86
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#define PIXEL_CONVERT_AVX2
+#else
+#define PIXEL_CONVERT_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+// Rows smaller than this are not worth handing to another thread
+#define MIN_BATCH_BYTES (64 * 1024)
+
+// premultiplied[a * 256 + c] is c decoded to linear, scaled by a / 255 and encoded back to sRGB.
+// 64KB, so the lookups stay in L2 and every path produces identical results.
+struct SRGBPremultiplyTable
+{
+    uint8_t premultiplied[256 * 256];
+
+    SRGBPremultiplyTable()
+    {
+        for (uint32_t c = 0; c < 256; ++c)
+        {
+            double s = c / 255.0;
+            double linear = s <= 0.04045 ? s / 12.92 : pow((s + 0.055) / 1.055, 2.4);
+
+            for (uint32_t a = 0; a < 256; ++a)
+            {
+                double l = linear * (a / 255.0);
+                double encoded = l <= 0.0031308 ? l * 12.92 : 1.055 * pow(l, 1.0 / 2.4) - 0.055;
+
+                premultiplied[a * 256 + c] = (uint8_t)(encoded * 255.0 + 0.5);
+            }
+        }
+    }
+};
+
+static const uint8_t *GetSRGBPremultiplyTable()
+{
+    static SRGBPremultiplyTable table;
+    return table.premultiplied;
+}
+
+// Exact round(c * a / 255) without a divide
+static inline uint8_t MulAlpha(uint32_t c, uint32_t a)
+{
+    uint32_t x = c * a + 128;
+    return (uint8_t)((x + (x >> 8)) >> 8);
+}
+
+static void PremultiplyScalar(uint8_t *dst, const uint8_t *src, uint32_t count)
+{
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        uint32_t a = src[i * 4 + 3];
+
+        dst[i * 4 + 0] = MulAlpha(src[i * 4 + 0], a);
+        dst[i * 4 + 1] = MulAlpha(src[i * 4 + 1], a);
+        dst[i * 4 + 2] = MulAlpha(src[i * 4 + 2], a);
+        dst[i * 4 + 3] = (uint8_t)a;
+    }
+}
+
+static void PremultiplySRGBScalar(uint8_t *dst, const uint8_t *src, uint32_t count)
+{
+    const uint8_t *table = GetSRGBPremultiplyTable();
+
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        uint8_t a = src[i * 4 + 3];
+        const uint8_t *row = table + a * 256;
+
+        dst[i * 4 + 0] = row[src[i * 4 + 0]];
+        dst[i * 4 + 1] = row[src[i * 4 + 1]];
+        dst[i * 4 + 2] = row[src[i * 4 + 2]];
+        dst[i * 4 + 3] = a;
+    }
+}
+
+static void SwizzleRBScalar(uint8_t *dst, const uint8_t *src, uint32_t count)
+{
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        uint8_t r = src[i * 4 + 0];
+        uint8_t b = src[i * 4 + 2];
+
+        dst[i * 4 + 0] = b;
+        dst[i * 4 + 1] = src[i * 4 + 1];
+        dst[i * 4 + 2] = r;
+        dst[i * 4 + 3] = src[i * 4 + 3];
+    }
+}
+
+#ifdef PIXEL_CONVERT_X86
+
+// Two RGBA pixels widened to 16 bit lanes, multiplied by their alpha (255 for the alpha lane itself)
+static inline __m128i MulAlpha16SSE2(__m128i c)
+{
+    const __m128i rgbMask = _mm_set_epi16(0, -1, -1, -1, 0, -1, -1, -1);
+    const __m128i alphaOne = _mm_set_epi16(255, 0, 0, 0, 255, 0, 0, 0);
+
+    __m128i a = _mm_shufflehi_epi16(_mm_shufflelo_epi16(c, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+    a = _mm_or_si128(_mm_and_si128(a, rgbMask), alphaOne);
+
+    __m128i x = _mm_add_epi16(_mm_mullo_epi16(c, a), _mm_set1_epi16(128));
+    return _mm_srli_epi16(_mm_add_epi16(x, _mm_srli_epi16(x, 8)), 8);
+}
+
+static void PremultiplySSE2(uint8_t *dst, const uint8_t *src, uint32_t count)
+{
+    const __m128i zero = _mm_setzero_si128();
+
+    uint32_t i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128i pixels = _mm_loadu_si128((const __m128i *)(src + i * 4));
+
+        __m128i lo = MulAlpha16SSE2(_mm_unpacklo_epi8(pixels, zero));
+        __m128i hi = MulAlpha16SSE2(_mm_unpackhi_epi8(pixels, zero));
+
+        _mm_storeu_si128((__m128i *)(dst + i * 4), _mm_packus_epi16(lo, hi));
+    }
+
+    PremultiplyScalar(dst + i * 4, src + i * 4, count - i);
+}
+
+static void SwizzleRBSSE2(uint8_t *dst, const uint8_t *src, uint32_t count)
+{
+    const __m128i gaMask = _mm_set1_epi32((int)0xFF00FF00);
+    const __m128i lowMask = _mm_set1_epi32(0xFF);
+
+    uint32_t i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128i pixels = _mm_loadu_si128((const __m128i *)(src + i * 4));
+
+        __m128i ga = _mm_and_si128(pixels, gaMask);
+        __m128i r = _mm_slli_epi32(_mm_and_si128(pixels, lowMask), 16);
+        __m128i b = _mm_and_si128(_mm_srli_epi32(pixels, 16), lowMask);
+
+        _mm_storeu_si128((__m128i *)(dst + i * 4), _mm_or_si128(ga, _mm_or_si128(r, b)));
+    }
+
+    SwizzleRBScalar(dst + i * 4, src + i * 4, count - i);
+}
+
+static inline PIXEL_CONVERT_AVX2 __m256i MulAlpha16AVX2(__m256i c)
+{
+    const __m256i alphaShuffle = _mm256_set_epi8(
+        15, 14, 15, 14, 15, 14, 15, 14, 7, 6, 7, 6, 7, 6, 7, 6,
+        15, 14, 15, 14, 15, 14, 15, 14, 7, 6, 7, 6, 7, 6, 7, 6);
+    const __m256i rgbMask = _mm256_set_epi16(0, -1, -1, -1, 0, -1, -1, -1, 0, -1, -1, -1, 0, -1, -1, -1);
+    const __m256i alphaOne = _mm256_set_epi16(255, 0, 0, 0, 255, 0, 0, 0, 255, 0, 0, 0, 255, 0, 0, 0);
+
+    __m256i a = _mm256_or_si256(_mm256_and_si256(_mm256_shuffle_epi8(c, alphaShuffle), rgbMask), alphaOne);
+
+    __m256i x = _mm256_add_epi16(_mm256_mullo_epi16(c, a), _mm256_set1_epi16(128));
+    return _mm256_srli_epi16(_mm256_add_epi16(x, _mm256_srli_epi16(x, 8)), 8);
+}
+
+// The unpacks and the pack both work within 128 bit lanes, so pixel order comes out unchanged
+static PIXEL_CONVERT_AVX2 void PremultiplyAVX2(uint8_t *dst, const uint8_t *src, uint32_t count)
+{
+    const __m256i zero = _mm256_setzero_si256();
+
+    uint32_t i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        __m256i pixels = _mm256_loadu_si256((const __m256i *)(src + i * 4));
+
+        __m256i lo = MulAlpha16AVX2(_mm256_unpacklo_epi8(pixels, zero));
+        __m256i hi = MulAlpha16AVX2(_mm256_unpackhi_epi8(pixels, zero));
+
+        _mm256_storeu_si256((__m256i *)(dst + i * 4), _mm256_packus_epi16(lo, hi));
+    }
+
+    PremultiplyScalar(dst + i * 4, src + i * 4, count - i);
+}
+
+// Sprites are mostly fully opaque or fully transparent, and both pass through unchanged (transparent
+// pixels become zero). Only blocks with partial coverage fall back to the table.
+static void PremultiplySRGBSSE2(uint8_t *dst, const uint8_t *src, uint32_t count)
+{
+    const __m128i alphaMask = _mm_set1_epi32((int)0xFF000000);
+
+    uint32_t i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128i pixels = _mm_loadu_si128((const __m128i *)(src + i * 4));
+        __m128i alpha = _mm_and_si128(pixels, alphaMask);
+
+        if (_mm_movemask_epi8(_mm_cmpeq_epi32(alpha, alphaMask)) == 0xFFFF)
+            _mm_storeu_si128((__m128i *)(dst + i * 4), pixels);
+        else if (_mm_movemask_epi8(_mm_cmpeq_epi32(alpha, _mm_setzero_si128())) == 0xFFFF)
+            _mm_storeu_si128((__m128i *)(dst + i * 4), _mm_setzero_si128());
+        else
+            PremultiplySRGBScalar(dst + i * 4, src + i * 4, 4);
+    }
+
+    PremultiplySRGBScalar(dst + i * 4, src + i * 4, count - i);
+}
+
+static PIXEL_CONVERT_AVX2 void PremultiplySRGBAVX2(uint8_t *dst, const uint8_t *src, uint32_t count)
+{
+    const __m256i alphaMask = _mm256_set1_epi32((int)0xFF000000);
+
+    uint32_t i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        __m256i pixels = _mm256_loadu_si256((const __m256i *)(src + i * 4));
+        __m256i alpha = _mm256_and_si256(pixels, alphaMask);
+
+        if (_mm256_movemask_epi8(_mm256_cmpeq_epi32(alpha, alphaMask)) == -1)
+            _mm256_storeu_si256((__m256i *)(dst + i * 4), pixels);
+        else if (_mm256_movemask_epi8(_mm256_cmpeq_epi32(alpha, _mm256_setzero_si256())) == -1)
+            _mm256_storeu_si256((__m256i *)(dst + i * 4), _mm256_setzero_si256());
+        else
+            PremultiplySRGBScalar(dst + i * 4, src + i * 4, 8);
+    }
+
+    PremultiplySRGBScalar(dst + i * 4, src + i * 4, count - i);
+}
+
+static PIXEL_CONVERT_AVX2 void SwizzleRBAVX2(uint8_t *dst, const uint8_t *src, uint32_t count)
+{
+    const __m256i shuffle = _mm256_set_epi8(
+        15, 12, 13, 14, 11, 8, 9, 10, 7, 4, 5, 6, 3, 0, 1, 2,
+        15, 12, 13, 14, 11, 8, 9, 10, 7, 4, 5, 6, 3, 0, 1, 2);
+
+    uint32_t i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        __m256i pixels = _mm256_loadu_si256((const __m256i *)(src + i * 4));
+        _mm256_storeu_si256((__m256i *)(dst + i * 4), _mm256_shuffle_epi8(pixels, shuffle));
+    }
+
+    SwizzleRBScalar(dst + i * 4, src + i * 4, count - i);
+}
+
+static bool IsAVX2Supported()
+{
+#ifdef _MSC_VER
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7)
+        return false;
+
+    // The OS also has to save the YMM registers across context switches
+    __cpuid(info, 1);
+    bool osxsave = (info[2] & (1 << 27)) != 0;
+    bool avx = (info[2] & (1 << 28)) != 0;
+    if (!osxsave || !avx || (_xgetbv(0) & 0x6) != 0x6)
+        return false;
+
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+
+#endif
+
+typedef void (*PixelKernel)(uint8_t *dst, const uint8_t *src, uint32_t count);
+
+struct PixelKernels
+{
+    PixelKernel premultiply;
+    PixelKernel premultiplySRGB;
+    PixelKernel swizzleRB;
+};
+
+static PixelConvertPath ResolvePath(PixelConvertPath path)
+{
+    if (path != PixelConvertPathBest)
+        return path;
+
+#ifdef PIXEL_CONVERT_X86
+    static PixelConvertPath best = IsAVX2Supported() ? PixelConvertPathAVX2 : PixelConvertPathSSE2;
+    return best;
+#else
+    return PixelConvertPathScalar;
+#endif
+}
+
+bool IsPixelConvertPathSupported(PixelConvertPath path)
+{
+    switch (path)
+    {
+        case PixelConvertPathBest:
+        case PixelConvertPathScalar:
+            return true;
+#ifdef PIXEL_CONVERT_X86
+        case PixelConvertPathSSE2:
+            return true;
+        case PixelConvertPathAVX2:
+            return IsAVX2Supported();
+#endif
+        default:
+            return false;
+    }
+}
+
+static PixelKernels GetKernels(PixelConvertPath path)
+{
+    switch (path)
+    {
+#ifdef PIXEL_CONVERT_X86
+        case PixelConvertPathSSE2: return { PremultiplySSE2, PremultiplySRGBSSE2, SwizzleRBSSE2 };
+        case PixelConvertPathAVX2: return { PremultiplyAVX2, PremultiplySRGBAVX2, SwizzleRBAVX2 };
+#endif
+        default: return { PremultiplyScalar, PremultiplySRGBScalar, SwizzleRBScalar };
+    }
+}
+
+void ConvertPixels(uint8_t *dst, const uint8_t *src, uint32_t width, uint32_t height, uint32_t texelSize, uint32_t flags, PixelConvertPath path /* = PixelConvertPathBest */)
+{
+    assert(texelSize == 4 || (flags & ~PixelConvertFlipY) == 0);
+
+    if (width == 0 || height == 0)
+        return;
+
+    path = ResolvePath(path);
+    assert(IsPixelConvertPathSupported(path));
+
+    PixelKernels kernels = GetKernels(path);
+
+    PixelKernel chain[3];
+    uint32_t chainLength = 0;
+
+    if (flags & PixelConvertPremultiply)
+        chain[chainLength++] = kernels.premultiply;
+    if (flags & PixelConvertPremultiplySRGB)
+        chain[chainLength++] = kernels.premultiplySRGB;
+    if (flags & PixelConvertSwizzleRB)
+        chain[chainLength++] = kernels.swizzleRB;
+
+    // Built up front so the workers do not all wait on the first use
+    if (flags & PixelConvertPremultiplySRGB)
+        GetSRGBPremultiplyTable();
+
+    uint32_t rowSize = width * texelSize;
+    bool flip = (flags & PixelConvertFlipY) != 0;
+
+    ParallelFor(height, MIN_BATCH_BYTES / rowSize + 1, [&](uint32_t begin, uint32_t end)
+    {
+        // Intermediate steps stay in a cached scratch row, only the last one writes to dst
+        std::vector<uint8_t> scratch(chainLength > 1 ? rowSize : 0);
+
+        for (uint32_t y = begin; y < end; ++y)
+        {
+            const uint8_t *in = src + (size_t)y * rowSize;
+            uint8_t *out = dst + (size_t)(flip ? height - 1 - y : y) * rowSize;
+
+            if (chainLength == 0)
+            {
+                memcpy(out, in, rowSize);
+                continue;
+            }
+
+            for (uint32_t i = 0; i < chainLength; ++i)
+            {
+                uint8_t *target = i + 1 == chainLength ? out : scratch.data();
+                chain[i](target, in, width);
+                in = target;
+            }
+        }
+    });
+}
\ No newline at end of file
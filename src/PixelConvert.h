@@ -0,0 +1,27 @@
+#pragma once
+
+#include <stdint.h>
+
+// Conversions applied while copying decoded images into staging memory. Everything except the
+// flip requires 4 byte RGBA texels.
+enum PixelConversionFlags
+{
+    PixelConvertFlipY = 1 << 0,
+    PixelConvertSwizzleRB = 1 << 1,         // RGBA <-> BGRA
+    PixelConvertPremultiply = 1 << 2,       // Multiplies the stored values directly, for UNORM data
+    PixelConvertPremultiplySRGB = 1 << 3    // Decodes to linear, multiplies and re-encodes, for sRGB data
+};
+
+enum PixelConvertPath
+{
+    PixelConvertPathBest,
+    PixelConvertPathScalar,
+    PixelConvertPathSSE2,
+    PixelConvertPathAVX2
+};
+
+bool IsPixelConvertPathSupported(PixelConvertPath path);
+
+// Rows are split across the job system. dst is written exactly once per texel and never read, so
+// it can point straight at mapped (possibly write combined) staging memory.
+void ConvertPixels(uint8_t *dst, const uint8_t *src, uint32_t width, uint32_t height, uint32_t texelSize, uint32_t flags, PixelConvertPath path = PixelConvertPathBest);
\ No newline at end of file
@@ -2,26 +2,33 @@
 
 #include "Internal.h"
 #include "Utils.h"
-
-#include <stb_image.h>
+#include "JobSystem.h"
+#include "PipelineCache.h"
+#include "LayoutCache.h"
+#include "ShaderHotReload.h"
+#include "DrawData.h"
+#include "Path.h"
+#include "Font.h"
 
 #include <assert.h>
+#include <math.h>
 
+#include <string>
 #include <vector>
+#include <algorithm>
+#include <mutex>
 
 #include <glm/gtc/matrix_transform.hpp>
 
 Renderer renderer = { false };
 
-#define QUAD_VERTEX_COUNT 6
+// Drawn with the first QUAD_INDEX_COUNT indices of the shared quad index buffer
+#define QUAD_INDEX_COUNT 6
 std::vector<float> unitSquare = {
     0.0f, 1.0f,
     1.0f, 1.0f,
     1.0f, 0.0f,
-
-    1.0f, 0.0f,
-    0.0f, 0.0f,
-    0.0f, 1.0f
+    0.0f, 0.0f
 };
 
 #define LINE_VERTEX_COUNT 2
@@ -29,6 +36,21 @@ std::vector<float> unitLine = {
     0.0f, 0.0f, 1.0f, 0.0f
 };
 
+#define STAGING_RING_SIZE (8 * 1024 * 1024)
+// Room for this many batched sprites per frame, so typical scenes never wait on the ring growing
+#define VERTEX_RING_SPRITES (128 * 1024)
+#define VERTEX_RING_SIZE ((uint32_t)(VERTEX_RING_SPRITES * SPRITE_VERTEX_COUNT * sizeof(BatchVertex)))
+#define INDEX_RING_SIZE (1024 * 1024)
+
+// Sprite vertices are allocated whole quads at a time, so a quad's index in the ring is its offset over this
+#define SPRITE_QUAD_SIZE ((uint32_t)(SPRITE_VERTEX_COUNT * sizeof(BatchVertex)))
+#define MAX_TEXTURE_SETS 4096
+
+// Set by CMake to the source tree's res/shaders
+#ifndef VK2D_SHADER_DIR
+#define VK2D_SHADER_DIR "../../../res/shaders"
+#endif
+
 VkBool32 VKAPI_PTR DebugCallback(VkDebugUtilsMessageSeverityFlagBitsEXT messageSeverity, VkDebugUtilsMessageTypeFlagsEXT messageTypes, const VkDebugUtilsMessengerCallbackDataEXT *pCallbackData, void *pUserData)
 {
     printf("%s\n", pCallbackData->pMessage);
@@ -36,6 +58,81 @@ VkBool32 VKAPI_PTR DebugCallback(VkDebugUtilsMessageSeverityFlagBitsEXT messageS
     return VK_FALSE;
 }
 
+static bool IsDeviceExtensionAvailable(VkPhysicalDevice device, const char *name)
+{
+    uint32_t extensionCount = 0;
+    vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionCount, nullptr);
+    std::vector<VkExtensionProperties> props(extensionCount);
+    vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionCount, props.data());
+
+    for (int i = 0; i < props.size(); ++i)
+    {
+        if (strcmp(props[i].extensionName, name) == 0)
+            return true;
+    }
+
+    return false;
+}
+
+// The feature structs are filled with what the device supports and chained into the device create info, whatever
+// is missing is baked into the pipeline variants instead
+static void *EnableDynamicStateFeatures(VkPhysicalDeviceExtendedDynamicStateFeaturesEXT *dynamicState, VkPhysicalDeviceExtendedDynamicState3FeaturesEXT *dynamicState3)
+{
+    renderer.dynamicTopology = false;
+    renderer.dynamicCullMode = false;
+    renderer.dynamicBlend = false;
+
+    *dynamicState = {};
+    dynamicState->sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_EXTENDED_DYNAMIC_STATE_FEATURES_EXT;
+
+    if (!IsDeviceExtensionAvailable(renderer.physicalDevice, VK_EXT_EXTENDED_DYNAMIC_STATE_EXTENSION_NAME))
+        return nullptr;
+
+    VkPhysicalDeviceFeatures2 features = {};
+    features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+    features.pNext = dynamicState;
+    vkGetPhysicalDeviceFeatures2(renderer.physicalDevice, &features);
+
+    if (!dynamicState->extendedDynamicState)
+        return nullptr;
+
+    renderer.deviceExtensions.push_back(VK_EXT_EXTENDED_DYNAMIC_STATE_EXTENSION_NAME);
+    renderer.dynamicCullMode = true;
+
+    void *next = dynamicState;
+
+    *dynamicState3 = {};
+    dynamicState3->sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_EXTENDED_DYNAMIC_STATE_3_FEATURES_EXT;
+
+    if (!IsDeviceExtensionAvailable(renderer.physicalDevice, VK_EXT_EXTENDED_DYNAMIC_STATE_3_EXTENSION_NAME))
+        return next;
+
+    features.pNext = dynamicState3;
+    vkGetPhysicalDeviceFeatures2(renderer.physicalDevice, &features);
+
+    VkPhysicalDeviceExtendedDynamicState3PropertiesEXT properties3 = {};
+    properties3.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_EXTENDED_DYNAMIC_STATE_3_PROPERTIES_EXT;
+
+    VkPhysicalDeviceProperties2 properties = {};
+    properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+    properties.pNext = &properties3;
+    vkGetPhysicalDeviceProperties2(renderer.physicalDevice, &properties);
+
+    // Lines and triangles are different topology classes, a shared pipeline can only switch between them when this is set
+    renderer.dynamicTopology = properties3.dynamicPrimitiveTopologyUnrestricted == VK_TRUE;
+    renderer.dynamicBlend = dynamicState3->extendedDynamicState3ColorBlendEnable && dynamicState3->extendedDynamicState3ColorBlendEquation;
+
+    if (renderer.dynamicTopology || renderer.dynamicBlend)
+    {
+        renderer.deviceExtensions.push_back(VK_EXT_EXTENDED_DYNAMIC_STATE_3_EXTENSION_NAME);
+
+        dynamicState3->pNext = next;
+        next = dynamicState3;
+    }
+
+    return next;
+}
+
 static bool CheckInstanceSupport()
 {
     uint32_t extensionCount = 0;
@@ -148,6 +245,187 @@ static bool IsDeviceSuitable(VkPhysicalDevice device)
     return true;
 }
 
+static VkRenderPass CreateColorRenderPass(VkFormat format, VkAttachmentLoadOp loadOp, VkImageLayout initialLayout, VkImageLayout finalLayout)
+{
+    VkAttachmentDescription attachment = {};
+    attachment.flags = 0;
+    attachment.format = format;
+    attachment.samples = VK_SAMPLE_COUNT_1_BIT;
+    attachment.loadOp = loadOp;
+    attachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+    attachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+    attachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+    attachment.initialLayout = initialLayout;
+    attachment.finalLayout = finalLayout;
+
+    VkAttachmentReference colorAttachmentRef = {};
+    colorAttachmentRef.attachment = 0;
+    colorAttachmentRef.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+
+    VkSubpassDescription subpass = {};
+    subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+    subpass.inputAttachmentCount = 0;
+    subpass.pInputAttachments = nullptr;
+    subpass.colorAttachmentCount = 1;
+    subpass.pColorAttachments = &colorAttachmentRef;
+    subpass.pResolveAttachments = nullptr;
+    subpass.pDepthStencilAttachment = nullptr;
+    subpass.preserveAttachmentCount = 0;
+    subpass.pPreserveAttachments = nullptr;
+
+    VkSubpassDependency dependency = {};
+    dependency.srcSubpass = VK_SUBPASS_EXTERNAL;
+    dependency.dstSubpass = 0;
+    dependency.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+    dependency.srcAccessMask = 0;
+    dependency.dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+    dependency.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+    dependency.dependencyFlags = 0;
+
+    VkRenderPassCreateInfo renderpassInfo = {};
+    renderpassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+    renderpassInfo.pNext = nullptr;
+    renderpassInfo.flags = 0;
+    renderpassInfo.attachmentCount = 1;
+    renderpassInfo.pAttachments = &attachment;
+    renderpassInfo.subpassCount = 1;
+    renderpassInfo.pSubpasses = &subpass;
+    renderpassInfo.dependencyCount = 1;
+    renderpassInfo.pDependencies = &dependency;
+
+    VkRenderPass renderPass;
+    VkCheck(vkCreateRenderPass(renderer.device, &renderpassInfo, nullptr, &renderPass));
+
+    return renderPass;
+}
+
+// The hot reload thread looks passes up too, when it prebuilds pipeline variants for render targets
+static std::mutex targetPassMutex;
+
+VkRenderPass GetTargetRenderPass(VkFormat format)
+{
+    std::lock_guard<std::mutex> lock(targetPassMutex);
+
+    auto it = renderer.targetPasses.find(format);
+    if (it != renderer.targetPasses.end())
+        return it->second;
+
+    // Render targets stay in COLOR_ATTACHMENT_OPTIMAL for the pass, SetRenderTarget handles the transitions
+    VkRenderPass renderPass = CreateColorRenderPass(format, VK_ATTACHMENT_LOAD_OP_LOAD, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL);
+    renderer.targetPasses[format] = renderPass;
+
+    return renderPass;
+}
+
+struct BuiltinPipeline
+{
+    GraphicsPipeline *pipeline;
+
+    const char *vertName;
+    const char *fragName;
+};
+
+// Embedded builds never touch the shader sources, the others compile them all at once from VK2D_SHADER_DIR
+static void CreateBuiltinPipelines(const BuiltinPipeline *builtins, uint32_t count)
+{
+    std::vector<Shader> shaders(count);
+    std::vector<std::string> vertPaths(count);
+    std::vector<std::string> fragPaths(count);
+
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        vertPaths[i] = std::string(VK2D_SHADER_DIR "/") + builtins[i].vertName;
+        fragPaths[i] = std::string(VK2D_SHADER_DIR "/") + builtins[i].fragName;
+    }
+
+#ifdef VK2D_EMBED_SHADERS
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        CreateShaderFromEmbedded(&shaders[i], builtins[i].vertName, builtins[i].fragName);
+    }
+#else
+    std::vector<ShaderSource> sources(count);
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        sources[i] = { vertPaths[i].c_str(), fragPaths[i].c_str(), nullptr };
+    }
+
+    std::string log;
+    if (!TryCreateShaders(shaders.data(), sources.data(), count, &log))
+    {
+        printf("%s\n", log.c_str());
+        __debugbreak();
+    }
+#endif
+
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        CreateGraphicsPipeline(builtins[i].pipeline, &shaders[i]);
+        RegisterReloadablePipeline(builtins[i].pipeline, vertPaths[i].c_str(), fragPaths[i].c_str());
+    }
+}
+
+static PipelineKey GetCurrentPipelineKey(VkPrimitiveTopology topology)
+{
+    PipelineKey key = {};
+    key.topology = topology;
+    key.blendMode = renderer.blendMode;
+    key.format = renderer.currentTargetFormat;
+    key.samples = VK_SAMPLE_COUNT_1_BIT;
+
+    // Nothing is blended in opaque mode, so textures are cut out at their edges instead
+    key.specialization = renderer.blendMode == BlendModeOpaque ? ShaderFeatureAlphaTest : 0;
+
+    return key;
+}
+
+// 0 1 2, 2 3 0 for every quad of the largest sprite batch, also used for single quads
+static std::vector<uint16_t> GetQuadIndices()
+{
+    std::vector<uint16_t> indices(SPRITE_BATCH_SIZE * SPRITE_INDEX_COUNT);
+
+    for (uint32_t quad = 0; quad < SPRITE_BATCH_SIZE; ++quad)
+    {
+        uint16_t first = (uint16_t)(quad * SPRITE_VERTEX_COUNT);
+        uint16_t *out = &indices[quad * SPRITE_INDEX_COUNT];
+
+        out[0] = first;
+        out[1] = first + 1;
+        out[2] = first + 2;
+        out[3] = first + 2;
+        out[4] = first + 3;
+        out[5] = first;
+    }
+
+    return indices;
+}
+
+// Sized to hold a record for every quad of the frame's vertex ring, and pointed to by its shapeSet
+static void CreateShapeRing(FrameResources &frame)
+{
+    uint32_t size = frame.vertexRing.buffer.size / SPRITE_QUAD_SIZE * sizeof(BatchShapeData);
+    CreateStagingRing(&frame.shapeRing, size, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VMA_MEMORY_USAGE_CPU_TO_GPU);
+
+    VkDescriptorBufferInfo bufferInfo = {};
+    bufferInfo.buffer = frame.shapeRing.buffer.buffer;
+    bufferInfo.offset = 0;
+    bufferInfo.range = size;
+
+    VkWriteDescriptorSet write = {};
+    write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    write.pNext = nullptr;
+    write.dstSet = frame.shapeSet;
+    write.dstBinding = 0;
+    write.dstArrayElement = 0;
+    write.descriptorCount = 1;
+    write.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    write.pImageInfo = nullptr;
+    write.pBufferInfo = &bufferInfo;
+    write.pTexelBufferView = nullptr;
+
+    vkUpdateDescriptorSets(renderer.device, 1, &write, 0, nullptr);
+}
+
 RendererResult RendererInit()
 {
     ZoneScopedN("Engine initialization");
@@ -166,7 +444,7 @@ RendererResult RendererInit()
     renderer.debug = true;
 #endif
 
-    stbi_set_flip_vertically_on_load(true);
+    InitJobSystem();
 
     renderer.result = volkInitialize();
     if (renderer.result == VK_ERROR_INITIALIZATION_FAILED)
@@ -253,6 +531,14 @@ RendererResult RendererInit()
 
     renderer.surface = PlatformGetSurface(renderer.currentWindow);
 
+    renderer.memoryBudgetSupported = IsDeviceExtensionAvailable(renderer.physicalDevice, VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+    if (renderer.memoryBudgetSupported)
+        renderer.deviceExtensions.push_back(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+
+    VkPhysicalDeviceExtendedDynamicStateFeaturesEXT dynamicStateFeatures;
+    VkPhysicalDeviceExtendedDynamicState3FeaturesEXT dynamicState3Features;
+    void *deviceNext = EnableDynamicStateFeatures(&dynamicStateFeatures, &dynamicState3Features);
+
     VkPhysicalDeviceFeatures enabledFeatures = {};
     enabledFeatures.fillModeNonSolid = VK_TRUE;
     enabledFeatures.samplerAnisotropy = VK_TRUE;
@@ -288,7 +574,7 @@ RendererResult RendererInit()
 
     VkDeviceCreateInfo deviceInfo = {};
     deviceInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
-    deviceInfo.pNext = nullptr;
+    deviceInfo.pNext = deviceNext;
     deviceInfo.flags = 0;
     deviceInfo.pEnabledFeatures = &enabledFeatures;
     deviceInfo.enabledExtensionCount = (uint32_t)renderer.deviceExtensions.size();
@@ -342,6 +628,8 @@ RendererResult RendererInit()
     allocatorInfo.physicalDevice = renderer.physicalDevice;
     allocatorInfo.device = renderer.device;
     allocatorInfo.pVulkanFunctions = &functions;
+    if (renderer.memoryBudgetSupported)
+        allocatorInfo.flags |= VMA_ALLOCATOR_CREATE_EXT_MEMORY_BUDGET_BIT;
 
     VkCheck(vmaCreateAllocator(&allocatorInfo, &renderer.allocator));
 
@@ -363,15 +651,18 @@ RendererResult RendererInit()
     renderer.ctx = TracyVkContext(renderer.physicalDevice, renderer.device, renderer.queue, tracyCmdBuf);
 
     std::vector<VkDescriptorPoolSize> sizes = {
-        { VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 5 },
-        { VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 5 }
+        { VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 16 },
+        { VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 16 },
+        { VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 16 },
+        { VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, MAX_TEXTURE_SETS }
     };
 
+    // Texture sets are returned to the pool when their texture is destroyed
     VkDescriptorPoolCreateInfo descriptorPoolInfo = {};
     descriptorPoolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
     descriptorPoolInfo.pNext = nullptr;
-    descriptorPoolInfo.flags = 0;
-    descriptorPoolInfo.maxSets = 10;
+    descriptorPoolInfo.flags = VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT;
+    descriptorPoolInfo.maxSets = 32 + MAX_TEXTURE_SETS;
     descriptorPoolInfo.poolSizeCount = (uint32_t)sizes.size();
     descriptorPoolInfo.pPoolSizes = sizes.data();
 
@@ -389,93 +680,22 @@ RendererResult RendererInit()
         DestroySwapchain(&renderer.swapchain);
     });
 
-    uint32_t vertexSize = (uint32_t)unitSquare.size() * sizeof(float);
-    CreateBuffer(&renderer.quadVertexBuffer, vertexSize, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, VMA_MEMORY_USAGE_CPU_TO_GPU);
-
-    vertexSize = (uint32_t)unitSquare.size() * sizeof(float);
-    CreateBuffer(&renderer.lineVertexBuffer, vertexSize, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, VMA_MEMORY_USAGE_CPU_TO_GPU);
-    
-    renderer.deletionQueue.push_back([&]()
-    {
-        DestroyBuffer(&renderer.lineVertexBuffer);
-        DestroyBuffer(&renderer.quadVertexBuffer);
-    });
-
-    void *mem = MapBufferMemory(&renderer.quadVertexBuffer);
-    memcpy(mem, unitSquare.data(), renderer.quadVertexBuffer.size);
-    UnmapBufferMemory(&renderer.quadVertexBuffer);
-
-    mem = MapBufferMemory(&renderer.lineVertexBuffer);
-    memcpy(mem, unitLine.data(), renderer.lineVertexBuffer.size);
-    UnmapBufferMemory(&renderer.lineVertexBuffer);
-
     // Default render pass initialization
-    std::vector<VkAttachmentDescription> attachments(1);
-    attachments[0].flags = 0;
-    attachments[0].format = renderer.swapchain.imageFormat;
-    attachments[0].samples = VK_SAMPLE_COUNT_1_BIT;
-    attachments[0].loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
-    attachments[0].storeOp = VK_ATTACHMENT_STORE_OP_STORE;
-    attachments[0].stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
-    attachments[0].stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-    attachments[0].initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-    attachments[0].finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
-
-    VkAttachmentReference colorAttachmentRef = {};
-    colorAttachmentRef.attachment = 0;
-    colorAttachmentRef.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
-
-    VkSubpassDescription subpass = {};
-    subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
-    subpass.inputAttachmentCount = 0;
-    subpass.pInputAttachments = nullptr;
-    subpass.colorAttachmentCount = 1;
-    subpass.pColorAttachments = &colorAttachmentRef;
-    subpass.pResolveAttachments = nullptr;
-    subpass.pDepthStencilAttachment = nullptr;
-    subpass.preserveAttachmentCount = 0;
-    subpass.pPreserveAttachments = nullptr;
-
-    VkSubpassDependency dependency = {};
-    dependency.srcSubpass = VK_SUBPASS_EXTERNAL;
-    dependency.dstSubpass = 0;
-    dependency.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-    dependency.srcAccessMask = 0;
-    dependency.dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-    dependency.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
-    dependency.dependencyFlags = 0;
-
-    VkRenderPassCreateInfo renderpassInfo = {};
-    renderpassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
-    renderpassInfo.pNext = nullptr;
-    renderpassInfo.flags = 0;
-    renderpassInfo.attachmentCount = 1;
-    renderpassInfo.pAttachments = attachments.data();
-    renderpassInfo.subpassCount = 1;
-    renderpassInfo.pSubpasses = &subpass;
-    renderpassInfo.dependencyCount = 1;
-    renderpassInfo.pDependencies = &dependency;
-
-    vkCreateRenderPass(renderer.device, &renderpassInfo, nullptr, &renderer.renderPass);
-
-    // Render to texture render pass initialization
-    attachments[0].initialLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
-    attachments[0].finalLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
-    attachments[0].loadOp = VK_ATTACHMENT_LOAD_OP_LOAD;
-
-    vkCreateRenderPass(renderer.device, &renderpassInfo, nullptr, &renderer.toTexturePass);
+    renderer.renderPass = CreateColorRenderPass(renderer.swapchain.imageFormat, VK_ATTACHMENT_LOAD_OP_CLEAR, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_PRESENT_SRC_KHR);
 
     // Switch to this renderpass after rendering to texture
-    attachments[0].initialLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
-    attachments[0].finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
-    attachments[0].loadOp = VK_ATTACHMENT_LOAD_OP_LOAD;
-
-    vkCreateRenderPass(renderer.device, &renderpassInfo, nullptr, &renderer.midRenderPass);
+    renderer.midRenderPass = CreateColorRenderPass(renderer.swapchain.imageFormat, VK_ATTACHMENT_LOAD_OP_LOAD, VK_IMAGE_LAYOUT_PRESENT_SRC_KHR, VK_IMAGE_LAYOUT_PRESENT_SRC_KHR);
 
     renderer.deletionQueue.push_back([=]()
     {
+        for (auto &pass : renderer.targetPasses)
+        {
+            vkDestroyRenderPass(renderer.device, pass.second, nullptr);
+        }
+
+        renderer.targetPasses.clear();
+
         vkDestroyRenderPass(renderer.device, renderer.midRenderPass, nullptr);
-        vkDestroyRenderPass(renderer.device, renderer.toTexturePass, nullptr);
         vkDestroyRenderPass(renderer.device, renderer.renderPass, nullptr);
     });
 
@@ -506,44 +726,44 @@ RendererResult RendererInit()
         });
     }
 
-    VkPipelineCacheCreateInfo cacheInfo = {};
-    cacheInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
-    cacheInfo.pNext = nullptr;
-    cacheInfo.flags = 0;
-    cacheInfo.initialDataSize = 0;
-    cacheInfo.pInitialData = nullptr;
+    CreatePipelineCache();
 
-    VkCheck(vkCreatePipelineCache(renderer.device, &cacheInfo, nullptr, &renderer.cache));
-
-    {
-        Shader shader = {};
-        CreateShader(&shader, "../../../res/shaders/texture.vert", "../../../res/shaders/texture.frag");
-
-        CreateGraphicsPipeline(&renderer.texturePipeline, &shader, VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST);
+    BuiltinPipeline builtins[] = {
+        { &renderer.texturePipeline, "texture.vert", "texture.frag" },
+        { &renderer.colorPipeline, "color.vert", "color.frag" },
+        { &renderer.spritePipeline, "sprite.vert", "sprite.frag" },
+        { &renderer.shapePipeline, "shape.vert", "shape.frag" }
+    };
 
-        DestroyShader(&shader);
-    }
+    CreateBuiltinPipelines(builtins, (uint32_t)(sizeof(builtins) / sizeof(builtins[0])));
 
-    {
-        Shader shader = {};
-        CreateShader(&shader, "../../../res/shaders/color.vert", "../../../res/shaders/color.frag");
+    // Everything else is created on first use, these would be needed by the first frame anyway
+    renderer.blendMode = BlendModeAlpha;
+    renderer.currentTargetFormat = renderer.swapchain.imageFormat;
 
-        CreateGraphicsPipeline(&renderer.colorQuadPipeline, &shader, VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST);
-        CreateGraphicsPipeline(&renderer.linePipeline, &shader, VK_PRIMITIVE_TOPOLOGY_LINE_LIST);
+    PipelineVariantRequest variants[] = {
+        { &renderer.texturePipeline, GetCurrentPipelineKey(VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST) },
+        { &renderer.colorPipeline, GetCurrentPipelineKey(VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST) },
+        { &renderer.colorPipeline, GetCurrentPipelineKey(VK_PRIMITIVE_TOPOLOGY_LINE_LIST) },
+        { &renderer.spritePipeline, GetCurrentPipelineKey(VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST) },
+        { &renderer.shapePipeline, GetCurrentPipelineKey(VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST) }
+    };
 
-        DestroyShader(&shader);
-    }
+    VkCheck(CreatePipelineVariants(variants, (uint32_t)(sizeof(variants) / sizeof(variants[0]))));
 
     renderer.deletionQueue.push_back([=]()
     {
-        DestroyGraphicsPipeline(&renderer.linePipeline);
-        DestroyGraphicsPipeline(&renderer.colorQuadPipeline);
+        DestroyGraphicsPipeline(&renderer.shapePipeline);
+        DestroyGraphicsPipeline(&renderer.spritePipeline);
+        DestroyGraphicsPipeline(&renderer.colorPipeline);
         DestroyGraphicsPipeline(&renderer.texturePipeline);
-        vkDestroyPipelineCache(renderer.device, renderer.cache, nullptr);
+        DestroyLayoutCache();
+        DestroyPipelineCache();
     });
 
     renderer.frames.resize(renderer.swapchain.imageCount);
     renderer.frameIndex = 0;
+    renderer.frameCounter = 0;
 
     float aspect = (float)renderer.swapchain.extent.width / (float)renderer.swapchain.extent.height;
     glm::mat4 projection = glm::ortho(0.0f, (float)renderer.swapchain.extent.width, 0.0f, (float)renderer.swapchain.extent.height, 0.0f, 1.0f);
@@ -558,7 +778,19 @@ RendererResult RendererInit()
         frame.renderFinishedSemaphore = CreateSemaphore();
 
         frame.commandBuffer = std::move(AllocateCommandBuffers(1)[0]);
-        frame.frameUBO = std::move(AllocateDescriptorSets(&renderer.colorQuadPipeline, 1, 0)[0]);
+        frame.uploadCommandBuffer = std::move(AllocateCommandBuffers(1)[0]);
+        frame.uploadRecording = false;
+        frame.acquired = false;
+
+        CreateStagingRing(&frame.stagingRing, STAGING_RING_SIZE);
+        CreateStagingRing(&frame.vertexRing, VERTEX_RING_SIZE, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, VMA_MEMORY_USAGE_CPU_TO_GPU);
+        frame.vertexRingOverflowed = false;
+        frame.shapeSet = std::move(AllocateDescriptorSets(&renderer.shapePipeline, 1, 2)[0]);
+        CreateShapeRing(frame);
+        CreateStagingRing(&frame.indexRing, INDEX_RING_SIZE, VK_BUFFER_USAGE_INDEX_BUFFER_BIT, VMA_MEMORY_USAGE_CPU_TO_GPU);
+        frame.indexRingOverflowed = false;
+
+        frame.frameUBO = std::move(AllocateDescriptorSets(&renderer.colorPipeline, 1, 0)[0]);
         CreateBuffer(&frame.frameBuffer, sizeof(projection), VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, VMA_MEMORY_USAGE_CPU_TO_GPU, false);
 
         void *mem = MapBufferMemory(&frame.frameBuffer);
@@ -584,19 +816,59 @@ RendererResult RendererInit()
 
         vkUpdateDescriptorSets(renderer.device, 1, &write, 0, nullptr);
 
+        InitFrameMaterialParams(frame);
+
         renderer.deletionQueue.push_back([&]()
         {
+            DestroyFrameMaterialParams(frame);
+            DestroyStagingRing(&frame.indexRing);
+            DestroyStagingRing(&frame.shapeRing);
+            DestroyStagingRing(&frame.vertexRing);
+            DestroyStagingRing(&frame.stagingRing);
             DestroyBuffer(&frame.frameBuffer);
         });
     }
 
+    // Built-in geometry lives in device local memory, the uploads go out with the first frame
+    std::vector<uint16_t> quadIndices = GetQuadIndices();
+
+    CreateStaticBuffer(&renderer.quadVertexBuffer, unitSquare.data(), (uint32_t)(unitSquare.size() * sizeof(float)), VK_BUFFER_USAGE_VERTEX_BUFFER_BIT);
+    CreateStaticBuffer(&renderer.lineVertexBuffer, unitLine.data(), (uint32_t)(unitLine.size() * sizeof(float)), VK_BUFFER_USAGE_VERTEX_BUFFER_BIT);
+    CreateStaticBuffer(&renderer.quadIndexBuffer, quadIndices.data(), (uint32_t)(quadIndices.size() * sizeof(uint16_t)), VK_BUFFER_USAGE_INDEX_BUFFER_BIT);
+
+    renderer.deletionQueue.push_back([&]()
+    {
+        DestroyBuffer(&renderer.quadIndexBuffer);
+        DestroyBuffer(&renderer.lineVertexBuffer);
+        DestroyBuffer(&renderer.quadVertexBuffer);
+    });
+
+    InitMaterials();
+
     return ResultSuccess;
 }
 
 void RendererShutdown()
 {
+    StopShaderHotReload();
+
+    ShutdownFonts();
+    ShutdownMaterials();
+
     vkDeviceWaitIdle(renderer.device);
 
+    for (uint32_t i = 0; i < renderer.frames.size(); ++i)
+    {
+        FrameResources &frame = renderer.frames[i];
+
+        for (auto it = frame.deletionQueue.rbegin(); it != frame.deletionQueue.rend(); ++it)
+        {
+            (*it)();
+        }
+
+        frame.deletionQueue.clear();
+    }
+
     for (auto it = renderer.deletionQueue.rbegin(); it != renderer.deletionQueue.rend(); ++it)
     {
         (*it)();
@@ -604,6 +876,8 @@ void RendererShutdown()
 
     renderer.deletionQueue.clear();
 
+    ShutdownJobSystem();
+
     vmaDestroyAllocator(renderer.allocator);
 
     TracyVkDestroy(renderer.ctx);
@@ -616,12 +890,12 @@ void RendererShutdown()
     vkDestroyInstance(renderer.instance, nullptr);    
 }
 
-static uint64_t HashSets(std::vector<VkDescriptorSet> sets)
+static uint64_t HashSets(const std::vector<VkDescriptorSet> &sets)
 {
     uint64_t hash = 0;
     for (uint32_t i = 0; i < sets.size(); ++i)
     {
-        uint64_t *pointer = (uint64_t *)&sets[i];
+        const uint64_t *pointer = (const uint64_t *)&sets[i];
         hash += (*pointer) + (i << 12);
     }
 
@@ -658,20 +932,150 @@ static void RecreateSwapchain()
     }
 }
 
+// Rings that were too small last time this frame was used are doubled before being rewound
+static void ResetDrawRing(StagingRing *ring, bool *overflowed, VkBufferUsageFlags usage)
+{
+    if (*overflowed)
+    {
+        uint32_t size = ring->buffer.size * 2;
+
+        DestroyStagingRing(ring);
+        CreateStagingRing(ring, size, usage, VMA_MEMORY_USAGE_CPU_TO_GPU);
+
+        *overflowed = false;
+    }
+
+    ResetStagingRing(ring);
+}
+
+FrameResources &AcquireCurrentFrame()
+{
+    FrameResources &frame = renderer.frames[renderer.frameIndex];
+
+    if (!frame.acquired)
+    {
+        vkWaitForFences(renderer.device, 1, &frame.renderFinishedFence, true, UINT64_MAX);
+        vkResetFences(renderer.device, 1, &frame.renderFinishedFence);
+
+        for (auto it = frame.deletionQueue.rbegin(); it != frame.deletionQueue.rend(); ++it)
+        {
+            (*it)();
+        }
+
+        frame.deletionQueue.clear();
+
+        ResetStagingRing(&frame.stagingRing);
+        ResetFrameMaterialParams(frame);
+
+        bool vertexRingGrows = frame.vertexRingOverflowed;
+        ResetDrawRing(&frame.vertexRing, &frame.vertexRingOverflowed, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT);
+
+        if (vertexRingGrows)
+        {
+            DestroyStagingRing(&frame.shapeRing);
+            CreateShapeRing(frame);
+        }
+
+        ResetDrawRing(&frame.indexRing, &frame.indexRingOverflowed, VK_BUFFER_USAGE_INDEX_BUFFER_BIT);
+
+        frame.acquired = true;
+    }
+
+    return frame;
+}
+
+VkCommandBuffer GetUploadCommandBuffer()
+{
+    FrameResources &frame = AcquireCurrentFrame();
+
+    if (!frame.uploadRecording)
+    {
+        vkResetCommandBuffer(frame.uploadCommandBuffer, 0);
+
+        VkCommandBufferBeginInfo beginInfo = {};
+        beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        beginInfo.pNext = nullptr;
+        beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+        beginInfo.pInheritanceInfo = nullptr;
+
+        VkCheck(vkBeginCommandBuffer(frame.uploadCommandBuffer, &beginInfo));
+
+        frame.uploadRecording = true;
+    }
+
+    return frame.uploadCommandBuffer;
+}
+
+StagingAllocation AllocateStaging(uint32_t size, uint32_t alignment)
+{
+    FrameResources &frame = AcquireCurrentFrame();
+
+    StagingAllocation allocation = {};
+
+    uint32_t offset = 0;
+    if (StagingRingAllocate(&frame.stagingRing, size, alignment, &offset))
+    {
+        allocation.buffer = frame.stagingRing.buffer.buffer;
+        allocation.offset = offset;
+        allocation.mapped = frame.stagingRing.mapped + offset;
+
+        return allocation;
+    }
+
+    // Too large for what is left of the ring, fall back to a dedicated buffer that lives until this frame retires
+    Buffer *overflow = new Buffer();
+    CreateBuffer(overflow, size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VMA_MEMORY_USAGE_CPU_ONLY);
+
+    allocation.buffer = overflow->buffer;
+    allocation.offset = 0;
+    allocation.mapped = (uint8_t *)MapBufferMemory(overflow);
+
+    frame.deletionQueue.push_back([=]()
+    {
+        UnmapBufferMemory(overflow);
+        DestroyBuffer(overflow);
+        delete overflow;
+    });
+
+    return allocation;
+}
+
+void SetShaderHotReload(bool enabled)
+{
+    if (enabled)
+        StartShaderHotReload(VK2D_SHADER_DIR);
+    else
+        StopShaderHotReload();
+}
+
 void RendererBeginFrame()
 {
     ZoneScopedN("RendererBeginFrame");
 
-    FrameResources &frame = renderer.frames[renderer.frameIndex];
+    FrameResources &frame = AcquireCurrentFrame();
+
+    ApplyShaderReloads();
 
     renderer.currentTarget = RENDER_TO_SCREEN;
+    renderer.currentTargetFormat = renderer.swapchain.imageFormat;
+    renderer.blendMode = BlendModeAlpha;
 
-    renderer.lastPipeline = nullptr;
+    renderer.lastPipeline = VK_NULL_HANDLE;
+    renderer.lastTopology = VK_PRIMITIVE_TOPOLOGY_MAX_ENUM;
+    renderer.lastBlendMode = (BlendMode)-1;
     renderer.lastBuffer = nullptr;
+    renderer.lastIndexBuffer = nullptr;
     renderer.lastSetHash = 0;
+    renderer.lastLayout = VK_NULL_HANDLE;
+    renderer.lastDynamicOffset = 0;
 
-    vkWaitForFences(renderer.device, 1, &frame.renderFinishedFence, true, UINT64_MAX);
-    vkResetFences(renderer.device, 1, &frame.renderFinishedFence);
+    renderer.spriteBatch.count = 0;
+    renderer.spriteBatch.shapeCount = 0;
+    renderer.batchTexture = nullptr;
+    renderer.geometryVertices.clear();
+    renderer.geometryIndices.clear();
+
+    UpdateTextureResidency();
 
     renderer.result = AcquireNextImage(&renderer.swapchain, &renderer.currentImage, frame.imageAvailableSemaphore);
 
@@ -685,6 +1089,10 @@ void RendererBeginFrame()
 
     VkCheck(vkBeginCommandBuffer(frame.commandBuffer, &cmdBeginInfo));
 
+    // Dynamic state isn't inherited between command buffers, nothing here is culled
+    if (renderer.dynamicCullMode)
+        vkCmdSetCullModeEXT(frame.commandBuffer, VK_CULL_MODE_NONE);
+
     VkClearValue clearValue = {};
     clearValue.color = { 0.0f, 0.0f, 0.0f, 1.0f };
 
@@ -705,6 +1113,9 @@ void RendererEndFrame()
 {
     ZoneScopedN("RendererEndFrame");
 
+    FlushBatches();
+    FlushGlyphUploads();
+
     FrameResources &frame = renderer.frames[renderer.frameIndex];
 
     vkCmdEndRenderPass(frame.commandBuffer);
@@ -713,6 +1124,17 @@ void RendererEndFrame()
 
     VkCheck(vkEndCommandBuffer(frame.commandBuffer));
 
+    std::vector<VkCommandBuffer> commandBuffers;
+    if (frame.uploadRecording)
+    {
+        VkCheck(vkEndCommandBuffer(frame.uploadCommandBuffer));
+        commandBuffers.push_back(frame.uploadCommandBuffer);
+
+        frame.uploadRecording = false;
+    }
+
+    commandBuffers.push_back(frame.commandBuffer);
+
     VkPipelineStageFlags dstStage = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
 
     VkSubmitInfo submitInfo = {};
@@ -721,43 +1143,50 @@ void RendererEndFrame()
     submitInfo.waitSemaphoreCount = 1;
     submitInfo.pWaitSemaphores = &frame.imageAvailableSemaphore;
     submitInfo.pWaitDstStageMask = &dstStage;
-    submitInfo.commandBufferCount = 1;
-    submitInfo.pCommandBuffers = &frame.commandBuffer;
+    submitInfo.commandBufferCount = (uint32_t)commandBuffers.size();
+    submitInfo.pCommandBuffers = commandBuffers.data();
     submitInfo.signalSemaphoreCount = 1;
     submitInfo.pSignalSemaphores = &frame.renderFinishedSemaphore;
 
     vkQueueSubmit(renderer.queue, 1, &submitInfo, frame.renderFinishedFence);
 
+    frame.acquired = false;
+
     renderer.result = PresentImage(&renderer.swapchain, frame.renderFinishedSemaphore);
     if (renderer.result == VK_SUBOPTIMAL_KHR || renderer.result == VK_ERROR_OUT_OF_DATE_KHR)
         RecreateSwapchain();
 
     renderer.frameIndex = (renderer.frameIndex + 1) % renderer.frames.size();
+    renderer.frameCounter++;
 }
 
-static void BackendRender(std::vector<VkDescriptorSet> sets, uint32_t vertexCount, Buffer *vertexBuffer, GraphicsPipeline *pipeline, glm::vec2 pos, glm::vec2 scale, glm::vec4 texCoord, glm::vec4 color)
+// Binds only what changed since the last draw of this frame
+static void BindDrawState(const std::vector<VkDescriptorSet> &sets, Buffer *vertexBuffer, Buffer *indexBuffer, VkIndexType indexType, GraphicsPipeline *pipeline, VkPrimitiveTopology topology, const uint32_t *dynamicOffset)
 {
     FrameResources &frame = renderer.frames[renderer.frameIndex];
 
     uint64_t hash = HashSets(sets);
 
-    struct
+    VkPipeline variant = GetPipelineVariant(pipeline, GetCurrentPipelineKey(topology));
+    if (variant != renderer.lastPipeline)
     {
-        glm::mat4 model;
-        glm::vec4 texCoord;
-        glm::vec4 color;
-    } pushBuffer;
-    pushBuffer.model = glm::translate(glm::mat4(1.0f), { pos.x, pos.y, 0.0f });
-    pushBuffer.model = glm::scale(pushBuffer.model, { scale.x, scale.y, 0.0f });
+        vkCmdBindPipeline(frame.commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, variant);
 
-    pushBuffer.texCoord = texCoord;
-    pushBuffer.color = color;
+        renderer.lastPipeline = variant;
+    }
+
+    if (renderer.dynamicTopology && topology != renderer.lastTopology)
+    {
+        vkCmdSetPrimitiveTopologyEXT(frame.commandBuffer, topology);
+
+        renderer.lastTopology = topology;
+    }
 
-    if (pipeline != renderer.lastPipeline)
+    if (renderer.dynamicBlend && renderer.blendMode != renderer.lastBlendMode)
     {
-        vkCmdBindPipeline(frame.commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline->pipeline);
+        CmdSetBlendMode(frame.commandBuffer, renderer.blendMode);
 
-        renderer.lastPipeline = pipeline;
+        renderer.lastBlendMode = renderer.blendMode;
     }
 
     if (vertexBuffer != renderer.lastBuffer)
@@ -768,11 +1197,30 @@ static void BackendRender(std::vector<VkDescriptorSet> sets, uint32_t vertexCoun
         renderer.lastBuffer = vertexBuffer;
     }
 
-    if (hash != renderer.lastSetHash)
+    // An index buffer always holds the same index type
+    if (indexBuffer && indexBuffer != renderer.lastIndexBuffer)
     {
-        vkCmdBindDescriptorSets(frame.commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline->layout, 0, (uint32_t)sets.size(), sets.data(), 0, nullptr);
+        vkCmdBindIndexBuffer(frame.commandBuffer, indexBuffer->buffer, 0, indexType);
+
+        renderer.lastIndexBuffer = indexBuffer;
+    }
+
+    // Layouts are deduplicated, so the same handle means the bound sets are still compatible.
+    // Only the last set may be dynamic, a new offset alone just rebinds that set.
+    if (hash != renderer.lastSetHash || pipeline->layout != renderer.lastLayout)
+    {
+        vkCmdBindDescriptorSets(frame.commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline->layout, 0, (uint32_t)sets.size(), sets.data(), dynamicOffset ? 1 : 0, dynamicOffset);
 
         renderer.lastSetHash = hash;
+        renderer.lastLayout = pipeline->layout;
+        renderer.lastDynamicOffset = dynamicOffset ? *dynamicOffset : 0;
+    }
+    else if (dynamicOffset && *dynamicOffset != renderer.lastDynamicOffset)
+    {
+        uint32_t last = (uint32_t)sets.size() - 1;
+        vkCmdBindDescriptorSets(frame.commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline->layout, last, 1, &sets[last], 1, dynamicOffset);
+
+        renderer.lastDynamicOffset = *dynamicOffset;
     }
 
     VkViewport viewport = {};
@@ -789,40 +1237,397 @@ static void BackendRender(std::vector<VkDescriptorSet> sets, uint32_t vertexCoun
 
     vkCmdSetViewport(frame.commandBuffer, 0, 1, &viewport);
     vkCmdSetScissor(frame.commandBuffer, 0, 1, &scissor);
+}
+
+static void FlushSpriteBatch()
+{
+    SpriteStream &batch = renderer.spriteBatch;
+    if (batch.count == 0)
+        return;
+
+    FrameResources &frame = renderer.frames[renderer.frameIndex];
+
+    TracyVkZone(renderer.ctx, frame.commandBuffer, "FlushSpriteBatch");
 
-    vkCmdPushConstants(frame.commandBuffer, pipeline->layout, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(pushBuffer), &pushBuffer);
-    vkCmdDraw(frame.commandBuffer, vertexCount, 1, 0, 0);
+    uint32_t vertexCount = batch.count * SPRITE_VERTEX_COUNT;
+
+    uint32_t offset;
+    if (!StagingRingAllocate(&frame.vertexRing, vertexCount * sizeof(BatchVertex), SPRITE_QUAD_SIZE, &offset))
+    {
+        // Dropped for this frame only, the ring is grown before the frame is reused
+        frame.vertexRingOverflowed = true;
+        batch.count = 0;
+        batch.shapeCount = 0;
+        return;
+    }
+
+    ExpandSprites(&batch, (BatchVertex *)(frame.vertexRing.mapped + offset));
+
+    std::vector<VkDescriptorSet> sets = {
+        frame.frameUBO,
+        GetTextureHot(GetTexture(renderer.batchTexture)).set
+    };
+
+    // Plain sprites skip the per quad records and the shape shader altogether
+    GraphicsPipeline *pipeline = &renderer.spritePipeline;
+    if (batch.shapeCount > 0)
+    {
+        WriteSpriteShapes(&batch, (BatchShapeData *)frame.shapeRing.mapped + offset / SPRITE_QUAD_SIZE);
+
+        sets.push_back(frame.shapeSet);
+        pipeline = &renderer.shapePipeline;
+    }
+
+    // The ring stays bound at offset 0, so consecutive batches don't rebind it
+    BindDrawState(sets, &frame.vertexRing.buffer, &renderer.quadIndexBuffer, VK_INDEX_TYPE_UINT16, pipeline, VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST, nullptr);
+    vkCmdDrawIndexed(frame.commandBuffer, batch.count * SPRITE_INDEX_COUNT, 1, 0, (int32_t)(offset / sizeof(BatchVertex)), 0);
+
+    batch.count = 0;
+    batch.shapeCount = 0;
 }
 
-void RenderQuad(glm::vec4 rect, glm::vec4 color)
+static void FlushGeometryBatch()
 {
+    std::vector<BatchVertex> &vertices = renderer.geometryVertices;
+    std::vector<uint32_t> &indices = renderer.geometryIndices;
+    if (indices.empty())
+        return;
+
     FrameResources &frame = renderer.frames[renderer.frameIndex];
-    
-    TracyVkZone(renderer.ctx, frame.commandBuffer, "RenderQuad");
+
+    TracyVkZone(renderer.ctx, frame.commandBuffer, "FlushGeometryBatch");
+
+    uint32_t vertexOffset;
+    uint32_t indexOffset;
+
+    // Dropped for this frame only like sprites, whichever ring was short is grown before the frame is reused.
+    // The overflow flags stay set for the rest of the frame, smaller batches after this one may still fit.
+    bool vertexAllocated = StagingRingAllocate(&frame.vertexRing, (uint32_t)(vertices.size() * sizeof(BatchVertex)), sizeof(BatchVertex), &vertexOffset);
+    bool indexAllocated = vertexAllocated && StagingRingAllocate(&frame.indexRing, (uint32_t)(indices.size() * sizeof(uint32_t)), sizeof(uint32_t), &indexOffset);
+
+    if (!vertexAllocated)
+        frame.vertexRingOverflowed = true;
+    else if (!indexAllocated)
+        frame.indexRingOverflowed = true;
+
+    if (!vertexAllocated || !indexAllocated)
+    {
+        vertices.clear();
+        indices.clear();
+        return;
+    }
+
+    memcpy(frame.vertexRing.mapped + vertexOffset, vertices.data(), vertices.size() * sizeof(BatchVertex));
+    memcpy(frame.indexRing.mapped + indexOffset, indices.data(), indices.size() * sizeof(uint32_t));
+
+    _Texture *white = GetTexture(renderer.whiteTexture);
+
+    MakeTextureResident(white);
+    renderer.texturePool.lastUsedFrames[white->index] = renderer.frameCounter;
 
     std::vector<VkDescriptorSet> sets = {
-        frame.frameUBO
+        frame.frameUBO,
+        GetTextureHot(white).set
     };
 
-    BackendRender(sets, QUAD_VERTEX_COUNT, &renderer.quadVertexBuffer, &renderer.colorQuadPipeline, { rect.x, rect.y }, { rect.z, rect.w }, {}, color);
+    BindDrawState(sets, &frame.vertexRing.buffer, &frame.indexRing.buffer, VK_INDEX_TYPE_UINT32, &renderer.spritePipeline, VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST, nullptr);
+    vkCmdDrawIndexed(frame.commandBuffer, (uint32_t)indices.size(), 1, indexOffset / sizeof(uint32_t), (int32_t)(vertexOffset / sizeof(BatchVertex)), 0);
+
+    vertices.clear();
+    indices.clear();
+}
+
+static void FlushBatches()
+{
+    FlushSpriteBatch();
+    FlushGeometryBatch();
+}
+
+// Appends triangles to the geometry batch, after drawing any sprites queued before them
+static void QueueGeometry(const PathGeometry &geometry, glm::vec2 offset, glm::vec4 color)
+{
+    if (geometry.indices.empty())
+        return;
+
+    FlushSpriteBatch();
+
+    std::vector<BatchVertex> &vertices = renderer.geometryVertices;
+    std::vector<uint32_t> &indices = renderer.geometryIndices;
+
+    uint32_t base = (uint32_t)vertices.size();
+    uint32_t packed = PackColor(color);
+
+    vertices.resize(base + geometry.vertices.size());
+    for (size_t i = 0; i < geometry.vertices.size(); ++i)
+    {
+        BatchVertex &vertex = vertices[base + i];
+        vertex = {};
+        vertex.x = geometry.vertices[i].x + offset.x;
+        vertex.y = geometry.vertices[i].y + offset.y;
+        vertex.color = packed;
+    }
+
+    size_t first = indices.size();
+
+    indices.resize(first + geometry.indices.size());
+    for (size_t i = 0; i < geometry.indices.size(); ++i)
+    {
+        indices[first + i] = base + geometry.indices[i];
+    }
+}
+
+// count is an index count when there is an index buffer, otherwise a vertex count
+static void BackendRender(const std::vector<VkDescriptorSet> &sets, uint32_t count, Buffer *vertexBuffer, Buffer *indexBuffer, GraphicsPipeline *pipeline, VkPrimitiveTopology topology, const DrawData &data, const uint32_t *dynamicOffset = nullptr)
+{
+    FlushBatches();
+
+    FrameResources &frame = renderer.frames[renderer.frameIndex];
+
+    BindDrawState(sets, vertexBuffer, indexBuffer, VK_INDEX_TYPE_UINT16, pipeline, topology, dynamicOffset);
+
+    vkCmdPushConstants(frame.commandBuffer, pipeline->layout, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(data), &data);
+
+    if (indexBuffer)
+        vkCmdDrawIndexed(frame.commandBuffer, count, 1, 0, 0, 0);
+    else
+        vkCmdDraw(frame.commandBuffer, count, 1, 0, 0);
+}
+
+// Queues one quad of the sprite batch, flushing first when the texture changes or the batch is full
+static void QueueBatchQuad(Texture *handle, glm::vec2 position, glm::vec2 size, float rotation, glm::vec2 origin, glm::vec4 texCoord, glm::vec4 color, BatchShape shape = BatchShapeSprite, uint32_t shapeParams = 0)
+{
+    FlushGeometryBatch();
+
+    SpriteStream &batch = renderer.spriteBatch;
+    if (handle != renderer.batchTexture || batch.count == SPRITE_BATCH_SIZE)
+    {
+        FlushSpriteBatch();
+
+        _Texture *texture = GetTexture(handle);
+
+        MakeTextureResident(texture);
+        renderer.texturePool.lastUsedFrames[texture->index] = renderer.frameCounter;
+
+        renderer.batchTexture = handle;
+    }
+
+    uint32_t i = batch.count++;
+
+    batch.x[i] = position.x;
+    batch.y[i] = position.y;
+    batch.cosine[i] = rotation == 0.0f ? 1.0f : cosf(rotation);
+    batch.sine[i] = rotation == 0.0f ? 0.0f : sinf(rotation);
+
+    batch.left[i] = -origin.x;
+    batch.top[i] = -origin.y;
+    batch.right[i] = size.x - origin.x;
+    batch.bottom[i] = size.y - origin.y;
+
+    batch.texStart[i] = glm::packUnorm2x16({ texCoord.x, texCoord.y });
+    batch.texEnd[i] = glm::packUnorm2x16({ texCoord.x + texCoord.z, texCoord.y + texCoord.w });
+    batch.color[i] = PackColor(color);
+
+    batch.shapeParams[i] = shapeParams;
+    batch.shape[i] = shape;
+
+    if (shape != BatchShapeSprite)
+        ++batch.shapeCount;
+}
+
+// Shapes are centered on their quad, which is padded so the anti-aliased edge isn't cut off
+static void QueueShape(BatchShape shape, glm::vec2 center, glm::vec2 size, float cornerRadius, float thickness, glm::vec4 color)
+{
+    glm::vec2 padded = size + glm::vec2(SHAPE_PADDING * 2.0f);
+
+    uint32_t params = glm::packHalf2x16({ cornerRadius, thickness });
+    QueueBatchQuad(renderer.whiteTexture, center, padded, 0.0f, padded * 0.5f, glm::vec4(0.0f, 0.0f, 1.0f, 1.0f), color, shape, params);
+}
+
+void RenderQuad(glm::vec4 rect, glm::vec4 color)
+{
+    // Plain quads share the sprite batch with shapes and untextured sprites
+    QueueBatchQuad(renderer.whiteTexture, { rect.x, rect.y }, { rect.z, rect.w }, 0.0f, glm::vec2(0.0f), glm::vec4(0.0f, 0.0f, 1.0f, 1.0f), color);
 }
 
 void RenderTexture(Texture *handle, glm::vec4 rect, glm::vec4 texCoord, glm::vec4 color)
 {
-    _Texture *texture = (_Texture *)handle;
+    _Texture *texture = GetTexture(handle);
 
     FrameResources &frame = renderer.frames[renderer.frameIndex];
 
     TracyVkZone(renderer.ctx, frame.commandBuffer, "RenderTexture");
 
+    MakeTextureResident(texture);
+    renderer.texturePool.lastUsedFrames[texture->index] = renderer.frameCounter;
+
     std::vector<VkDescriptorSet> sets = {
         frame.frameUBO,
-        texture->set
+        GetTextureHot(texture).set
     };
 
-    glm::vec4 coord = texCoord;
+    BackendRender(sets, QUAD_INDEX_COUNT, &renderer.quadVertexBuffer, &renderer.quadIndexBuffer, &renderer.texturePipeline, VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST, MakeDrawData({ rect.x, rect.y }, { rect.z, rect.w }, texCoord, color));
+}
+
+void RenderSpriteEx(Texture *handle, glm::vec2 position, glm::vec2 size, float rotation, glm::vec2 origin, glm::vec4 texCoord, glm::vec4 color)
+{
+    QueueBatchQuad(handle ? handle : renderer.whiteTexture, position, size, rotation, origin, texCoord, color);
+}
+
+void RenderCircle(glm::vec2 center, float radius, glm::vec4 color)
+{
+    QueueShape(BatchShapeCircle, center, glm::vec2(radius * 2.0f), 0.0f, 0.0f, color);
+}
+
+void RenderRing(glm::vec2 center, float radius, float thickness, glm::vec4 color)
+{
+    QueueShape(BatchShapeCircle, center, glm::vec2(radius * 2.0f), 0.0f, thickness, color);
+}
+
+void RenderRoundedRect(glm::vec4 rect, float cornerRadius, glm::vec4 color, float outlineThickness)
+{
+    QueueShape(BatchShapeRoundedRect, { rect.x + rect.z * 0.5f, rect.y + rect.w * 0.5f }, { rect.z, rect.w }, cornerRadius, outlineThickness, color);
+}
+
+void RenderPolyline(const glm::vec2 *points, uint32_t count, glm::vec4 color, const PolylineStyle &style /* = {} */)
+{
+    PathGeometry geometry;
+    TessellatePolyline(&geometry, points, count, style);
+
+    QueueGeometry(geometry, glm::vec2(0.0f), color);
+}
+
+void RenderPolygon(const glm::vec2 *points, uint32_t count, glm::vec4 color)
+{
+    PathGeometry geometry;
+    if (TessellatePolygon(&geometry, points, count))
+        QueueGeometry(geometry, glm::vec2(0.0f), color);
+}
+
+void RenderPathMesh(PathMesh *handle, glm::vec2 offset, glm::vec4 color)
+{
+    QueueGeometry(((_PathMesh *)handle)->geometry, offset, color);
+}
+
+// Glyphs of one RenderText call, sorted by atlas page before they are queued
+struct GlyphQuad
+{
+    uint32_t page;
+    glm::vec2 position;
+    glm::vec2 size;
+    glm::vec4 texCoord;
+};
+
+static std::vector<GlyphQuad> glyphQuads;
+
+void RenderText(Font *handle, const char *text, glm::vec2 position, float size, glm::vec4 color)
+{
+    _Font *font = (_Font *)handle;
+
+    uint32_t pixelSize = GetFontPixelSize(size);
+    const TextLayout &layout = GetTextLayout(font, text, pixelSize);
+
+    // Only differs from 1 past GLYPH_MAX_PIXEL_SIZE, where the bitmaps are magnified
+    float scale = size / (float)pixelSize;
+
+    // Glyphs land on whole pixels so the atlas texels map one to one
+    glm::vec2 origin = glm::floor(position + 0.5f);
+
+    glyphQuads.clear();
+    for (const PlacedGlyph &placed : layout.glyphs)
+    {
+        const GlyphCell *cell = GetGlyphCell(font, placed.glyph, pixelSize);
+        if (!cell)
+            continue;
+
+        GlyphQuad quad;
+        quad.page = cell->page;
+        quad.position = origin + (glm::floor(placed.pen + 0.5f) + glm::vec2(cell->left, cell->top)) * scale;
+        quad.size = glm::vec2(cell->width, cell->height) * scale;
+        // Bitmaps are stored top row first, while quads sample textures bottom up like loaded images, so
+        // the v range starts at the bottom row and runs upwards
+        quad.texCoord = glm::vec4(cell->x + GLYPH_PADDING, cell->y + GLYPH_PADDING + cell->height, cell->width, -(float)cell->height) / (float)GLYPH_PAGE_SIZE;
+
+        glyphQuads.push_back(quad);
+    }
+
+    // Stable, so glyphs that overlap keep their order within a page
+    std::stable_sort(glyphQuads.begin(), glyphQuads.end(), [](const GlyphQuad &a, const GlyphQuad &b)
+    {
+        return a.page < b.page;
+    });
+
+    for (const GlyphQuad &quad : glyphQuads)
+    {
+        QueueBatchQuad(GetGlyphPageTexture(quad.page), quad.position, quad.size, 0.0f, glm::vec2(0.0f), quad.texCoord, color);
+    }
+}
+
+glm::vec2 MeasureText(Font *handle, const char *text, float size)
+{
+    uint32_t pixelSize = GetFontPixelSize(size);
+    const TextLayout &layout = GetTextLayout((_Font *)handle, text, pixelSize);
+
+    return layout.extent * (size / (float)pixelSize);
+}
+
+// Queues the glyphs of the last RenderSdfText call as one layer, grow and softness are in atlas texels
+static void QueueMsdfLayer(glm::vec2 offset, glm::vec4 color, float grow, float softness)
+{
+    uint32_t params = glm::packHalf2x16({ grow, softness });
+
+    for (const GlyphQuad &quad : glyphQuads)
+    {
+        QueueBatchQuad(GetMsdfPageTexture(quad.page), quad.position + offset, quad.size, 0.0f, glm::vec2(0.0f), quad.texCoord, color, BatchShapeMsdfGlyph, params);
+    }
+}
+
+void RenderSdfText(Font *handle, const char *text, glm::vec2 position, float size, glm::vec4 color, const TextStyle &style /* = {} */)
+{
+    _Font *font = (_Font *)handle;
+
+    const TextLayout &layout = GetTextLayout(font, text, 0);
+    PrepareMsdfGlyphs(font, layout);
+
+    // Pixels per atlas texel
+    float scale = size / (float)MSDF_EM_SIZE;
+
+    glyphQuads.clear();
+    for (const PlacedGlyph &placed : layout.glyphs)
+    {
+        const MsdfGlyph *glyph = GetMsdfGlyph(font, placed.glyph);
+        if (!glyph)
+            continue;
+
+        GlyphQuad quad;
+        quad.page = glyph->page;
+        quad.position = position + placed.pen * size + glm::vec2(glyph->left, glyph->top) * scale;
+        quad.size = glm::vec2(glyph->width, glyph->height) * scale;
+        // Fields are generated top row first like glyph bitmaps, so the v range is flipped the same way
+        quad.texCoord = glm::vec4(glyph->x, glyph->y + glyph->height, glyph->width, -(float)glyph->height) / (float)MSDF_PAGE_SIZE;
+
+        glyphQuads.push_back(quad);
+    }
+
+    std::stable_sort(glyphQuads.begin(), glyphQuads.end(), [](const GlyphQuad &a, const GlyphQuad &b)
+    {
+        return a.page < b.page;
+    });
+
+    // Back to front, each layer is a full pass over the glyphs so they never cover each other's outlines
+    float grow = style.outlineWidth / scale;
 
-    BackendRender(sets, QUAD_VERTEX_COUNT, &renderer.quadVertexBuffer, &renderer.texturePipeline, { rect.x, rect.y }, { rect.z, rect.w }, coord, color);
+    if (style.shadowColor.a > 0.0f)
+        QueueMsdfLayer(style.shadowOffset, style.shadowColor, grow, style.shadowSoftness / scale);
+
+    if (grow > 0.0f && style.outlineColor.a > 0.0f)
+        QueueMsdfLayer(glm::vec2(0.0f), style.outlineColor, grow, 0.0f);
+
+    QueueMsdfLayer(glm::vec2(0.0f), color, 0.0f, 0.0f);
+}
+
+glm::vec2 MeasureSdfText(Font *handle, const char *text, float size)
+{
+    return GetTextLayout((_Font *)handle, text, 0).extent * size;
 }
 
 void RenderLine(glm::vec2 pos, glm::vec2 size, glm::vec4 color)
@@ -833,7 +1638,69 @@ void RenderLine(glm::vec2 pos, glm::vec2 size, glm::vec4 color)
         frame.frameUBO
     };
 
-    BackendRender(sets, LINE_VERTEX_COUNT, &renderer.lineVertexBuffer, &renderer.linePipeline, pos, size, {}, color);
+    BackendRender(sets, LINE_VERTEX_COUNT, &renderer.lineVertexBuffer, nullptr, &renderer.colorPipeline, VK_PRIMITIVE_TOPOLOGY_LINE_LIST, MakeDrawData(pos, size, {}, color));
+}
+
+void RenderMesh(Mesh *handle, glm::vec2 position, glm::vec2 scale, glm::vec4 color, Texture *texture, glm::vec4 texCoord)
+{
+    _Mesh *mesh = (_Mesh *)handle;
+
+    FrameResources &frame = renderer.frames[renderer.frameIndex];
+
+    TracyVkZone(renderer.ctx, frame.commandBuffer, "RenderMesh");
+
+    std::vector<VkDescriptorSet> sets = {
+        frame.frameUBO
+    };
+
+    GraphicsPipeline *pipeline = &renderer.colorPipeline;
+    if (texture)
+    {
+        _Texture *tex = GetTexture(texture);
+
+        MakeTextureResident(tex);
+        renderer.texturePool.lastUsedFrames[tex->index] = renderer.frameCounter;
+
+        sets.push_back(GetTextureHot(tex).set);
+        pipeline = &renderer.texturePipeline;
+    }
+
+    Buffer *indexBuffer = mesh->indexCount > 0 ? &mesh->indexBuffer : nullptr;
+    uint32_t count = indexBuffer ? mesh->indexCount : mesh->vertexCount;
+
+    BackendRender(sets, count, &mesh->vertexBuffer, indexBuffer, pipeline, VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST, MakeDrawData(position, scale, texCoord, color));
+}
+
+void RenderMaterialQuad(Material *handle, glm::vec4 rect, Texture *texture, glm::vec4 texCoord, glm::vec4 color)
+{
+    _Material *material = (_Material *)handle;
+
+    FrameResources &frame = renderer.frames[renderer.frameIndex];
+
+    TracyVkZone(renderer.ctx, frame.commandBuffer, "RenderMaterialQuad");
+
+    uint32_t offset;
+    if (!StagingRingAllocate(&frame.paramRing, MATERIAL_PARAMS_SIZE, renderer.uniformAlignment, &offset))
+    {
+        // Dropped for this frame only, the ring is grown before the frame is reused
+        frame.paramRingOverflowed = true;
+        return;
+    }
+
+    memcpy(frame.paramRing.mapped + offset, material->params, material->program->paramsSize);
+
+    _Texture *tex = GetTexture(texture ? texture : renderer.whiteTexture);
+
+    MakeTextureResident(tex);
+    renderer.texturePool.lastUsedFrames[tex->index] = renderer.frameCounter;
+
+    std::vector<VkDescriptorSet> sets = {
+        frame.frameUBO,
+        GetTextureHot(tex).set,
+        frame.paramSet
+    };
+
+    BackendRender(sets, QUAD_INDEX_COUNT, &renderer.quadVertexBuffer, &renderer.quadIndexBuffer, &material->program->pipeline, VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST, MakeDrawData({ rect.x, rect.y }, { rect.z, rect.w }, texCoord, color), &offset);
 }
 
 static void TransitionTargetImageLayout(_Texture *texture, VkImageLayout oldLayout, VkImageLayout newLayout)
@@ -846,7 +1713,7 @@ static void TransitionTargetImageLayout(_Texture *texture, VkImageLayout oldLayo
     barrier.newLayout = newLayout;
     barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
     barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-    barrier.image = texture->image;
+    barrier.image = GetTextureHot(texture).image;
     barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
     barrier.subresourceRange.baseMipLevel = 0;
     barrier.subresourceRange.levelCount = 1;
@@ -881,23 +1748,25 @@ void SetRenderTarget(Texture *texture)
     if (renderer.currentTarget == texture)
         return;
 
+    FlushBatches();
+
     FrameResources &frame = renderer.frames[renderer.frameIndex];
 
     vkCmdEndRenderPass(frame.commandBuffer);
 
-    _Texture *tex = (_Texture *)texture;
     bool isScreen = texture == RENDER_TO_SCREEN;
+    _Texture *tex = isScreen ? nullptr : GetTexture(texture);
     
     if (isScreen)
     {
-        TransitionTargetImageLayout((_Texture *)renderer.currentTarget, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+        TransitionTargetImageLayout(GetTexture(renderer.currentTarget), VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
     }
     else
     {
         TransitionTargetImageLayout(tex, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL);
     }
 
-    VkRenderPass currentPass = isScreen ? renderer.midRenderPass : renderer.toTexturePass;
+    VkRenderPass currentPass = isScreen ? renderer.midRenderPass : GetTargetRenderPass(tex->format);
     VkExtent2D extent = {};
     if (isScreen)
         extent = renderer.swapchain.extent;
@@ -920,4 +1789,13 @@ void SetRenderTarget(Texture *texture)
     vkCmdBeginRenderPass(frame.commandBuffer, &beginInfo, VK_SUBPASS_CONTENTS_INLINE);
 
     renderer.currentTarget = texture;
+    renderer.currentTargetFormat = isScreen ? renderer.swapchain.imageFormat : tex->format;
+}
+
+void SetBlendMode(BlendMode mode)
+{
+    if (mode != renderer.blendMode)
+        FlushBatches();
+
+    renderer.blendMode = mode;
 }
\ No newline at end of file
@@ -29,23 +29,200 @@ enum RendererResult
 RendererResult RendererInit();
 void RendererShutdown();
 
+// The pipeline cache is always saved at shutdown, this also saves it periodically from a background thread. 0 disables it.
+void SetPipelineCacheAutosave(uint32_t seconds);
+
+// Watches the shader sources and rebuilds the affected pipelines in the background when they change,
+// the new pipelines take effect at the next RendererBeginFrame. Meant for development builds.
+void SetShaderHotReload(bool enabled);
+
 void RendererBeginFrame();
 void RendererEndFrame();
 
 typedef struct Texture Texture;
 
-Texture *CreateTexture(uint32_t width, uint32_t height);
-Texture *LoadTextureFromPixels(uint32_t width, uint32_t height, uint8_t *pixels);
-Texture *LoadTextureFromFile(const char *filename);
+enum TextureFormat
+{
+    TextureFormatRGBA8,
+    TextureFormatBGRA8,
+    TextureFormatR8,        // Sampled as (1, 1, 1, r), for glyph and mask data
+    TextureFormatRG8,       // Sampled as (r, r, r, g)
+    TextureFormatRGBA16F,
+    TextureFormatRGBA8Linear,   // Not sRGB, for data such as distance fields
+
+    TextureFormatCount
+};
+
+enum TextureLoadFlags
+{
+    TextureLoadPremultiplyAlpha = 1 << 0    // Four channel formats only, sRGB ones are multiplied in linear space
+};
+
+bool IsTextureFormatSupported(TextureFormat format, bool renderTarget = false);
+
+Texture *CreateTexture(uint32_t width, uint32_t height, TextureFormat format = TextureFormatRGBA8);
+// Loading the same file, or the same pixels with deduplicate set, returns the existing texture.
+// Every load still needs its own DestroyTexture.
+Texture *LoadTextureFromPixels(uint32_t width, uint32_t height, uint8_t *pixels, TextureFormat format = TextureFormatRGBA8, bool deduplicate = false);
+Texture *LoadTextureFromFile(const char *filename, TextureFormat format = TextureFormatRGBA8, uint32_t flags = 0);
 
 glm::vec2 TextureGetExtent(Texture *handle);
 
+// False once the texture has been destroyed, even if its slot has been reused since
+bool IsTextureValid(Texture *texture);
+
+// Recorded into the current frame and applied before any of its draws, stride is in bytes (0 means tightly packed).
+// Textures shared by several loads of the same file or deduplicated pixels are refused.
+void UpdateTextureRegion(Texture *texture, uint32_t x, uint32_t y, uint32_t width, uint32_t height, const uint8_t *pixels, uint32_t stride = 0);
+
 void DestroyTexture(Texture *texture);
 
+// Caps the memory used by resident textures, least recently drawn textures are evicted past it.
+// 0 (the default) only evicts when the device reports being close to its memory budget.
+void SetTextureMemoryBudget(uint64_t bytes);
+
+// Packs are built offline with vk2d-packer and hold texel data that is ready to upload as-is
+typedef struct AssetPack AssetPack;
+
+// Textures loaded from a pack are evicted back to it, so the pack must stay open while they are alive
+AssetPack *OpenAssetPack(const char *filename);
+void CloseAssetPack(AssetPack *pack);
+
+Texture *LoadTextureFromPack(AssetPack *pack, const char *name);
+
+enum BlendMode
+{
+    BlendModeAlpha,             // Straight alpha, the default
+    BlendModeAdditive,
+    BlendModeMultiply,
+    BlendModePremultiplied,     // For textures loaded with TextureLoadPremultiplyAlpha and colors premultiplied by the caller
+    BlendModeOpaque             // Textures are alpha tested, texels below half coverage are discarded
+};
+
+// Applies to every draw after it until changed, resets to BlendModeAlpha at RendererBeginFrame
+void SetBlendMode(BlendMode mode);
+
 void RenderQuad(glm::vec4 rect, glm::vec4 color);
 void RenderTexture(Texture *texture, glm::vec4 rect, glm::vec4 texCoord = glm::vec4(0.0f, 0.0f, 1.0f, 1.0f), glm::vec4 color = glm::vec4(1.0f));
 void RenderLine(glm::vec2 pos, glm::vec2 size, glm::vec4 color);
 
+// Rotation is in radians around origin, which is relative to the sprite's top left corner and is placed at
+// position. Consecutive sprites with the same texture are drawn as one batch until any other draw, a blend
+// mode or render target change, or the end of the frame. A null texture draws a solid colored sprite.
+void RenderSpriteEx(Texture *texture, glm::vec2 position, glm::vec2 size, float rotation = 0.0f, glm::vec2 origin = glm::vec2(0.0f), glm::vec4 texCoord = glm::vec4(0.0f, 0.0f, 1.0f, 1.0f), glm::vec4 color = glm::vec4(1.0f));
+
+// Evaluated as signed distances per pixel, so edges are anti-aliased at any size and each shape is a single
+// quad in the same batch as RenderQuad and untextured sprites. Outlines and rings lie inside the given size.
+void RenderCircle(glm::vec2 center, float radius, glm::vec4 color);
+void RenderRing(glm::vec2 center, float radius, float thickness, glm::vec4 color);
+void RenderRoundedRect(glm::vec4 rect, float cornerRadius, glm::vec4 color, float outlineThickness = 0.0f);
+
+typedef struct Material Material;
+
+struct MaterialOptions
+{
+    const char *defines;    // #define lines compiled into both stages, may be null
+};
+
+// Material shaders follow the sprite interface: vec2 vertPos at location 0, the Camera block at set 0
+// binding 0, the push constants from res/shaders/draw.glsl, an optional sampler2D at set 1 binding 0 for
+// the fragment stage and their parameters in a uniform block at set 2 binding 0 of at most 256 bytes.
+// Materials created from the same sources and options share one pipeline, so any number of effect
+// instances with different parameters cost no extra pipelines or binds beyond a dynamic offset.
+Material *CreateMaterial(const char *vertPath, const char *fragPath, const MaterialOptions &options = {});
+void DestroyMaterial(Material *material);
+
+// Names are members of the parameter block, unknown names and mismatched types are reported and ignored.
+// Parameters start zeroed and are copied at draw time, so a change only affects later draws.
+void SetMaterialFloat(Material *material, const char *name, float value);
+void SetMaterialVec2(Material *material, const char *name, glm::vec2 value);
+void SetMaterialVec3(Material *material, const char *name, glm::vec3 value);
+void SetMaterialVec4(Material *material, const char *name, glm::vec4 value);
+void SetMaterialInt(Material *material, const char *name, int32_t value);
+
+// Without a texture the shader samples plain white
+void RenderMaterialQuad(Material *material, glm::vec4 rect, Texture *texture = nullptr, glm::vec4 texCoord = glm::vec4(0.0f, 0.0f, 1.0f, 1.0f), glm::vec4 color = glm::vec4(1.0f));
+
+enum LineJoin
+{
+    LineJoinMiter,
+    LineJoinBevel,
+    LineJoinRound
+};
+
+enum LineCap
+{
+    LineCapButt,
+    LineCapSquare,
+    LineCapRound
+};
+
+struct PolylineStyle
+{
+    float width = 1.0f;
+    LineJoin join = LineJoinMiter;
+    LineCap cap = LineCapButt;          // Ignored for closed polylines
+    bool closed = false;
+    float miterLimit = 4.0f;            // Miters reaching further than this many half widths are beveled
+};
+
+// Tessellated on the CPU into the batch stream, consecutive paths and polygons are drawn together.
+// RenderPolygon accepts concave outlines in either winding, but no holes.
+void RenderPolyline(const glm::vec2 *points, uint32_t count, glm::vec4 color, const PolylineStyle &style = {});
+void RenderPolygon(const glm::vec2 *points, uint32_t count, glm::vec4 color);
+
+typedef struct PathMesh PathMesh;
+
+// Keeps the tessellation of a static path, so drawing it again only copies its triangles into the batch.
+// Returns null when there is nothing to draw: a polyline needs 2 distinct points and a positive width,
+// a polygon 3 distinct points.
+PathMesh *CreatePolylineMesh(const glm::vec2 *points, uint32_t count, const PolylineStyle &style = {});
+PathMesh *CreatePolygonMesh(const glm::vec2 *points, uint32_t count);
+void DestroyPathMesh(PathMesh *mesh);
+
+void RenderPathMesh(PathMesh *mesh, glm::vec2 offset, glm::vec4 color);
+
+typedef struct Mesh Mesh;
+
+// Triangle lists that never change, uploaded once to device local memory. Vertices are in the same unit
+// space as a quad and are scaled by RenderMesh, a texture's uv rect maps onto [0, 1] of that space. indices
+// may be null to draw the vertices in order.
+Mesh *CreateMesh(const glm::vec2 *vertices, uint32_t vertexCount, const uint16_t *indices = nullptr, uint32_t indexCount = 0);
+void DestroyMesh(Mesh *mesh);
+
+void RenderMesh(Mesh *mesh, glm::vec2 position, glm::vec2 scale, glm::vec4 color = glm::vec4(1.0f), Texture *texture = nullptr, glm::vec4 texCoord = glm::vec4(0.0f, 0.0f, 1.0f, 1.0f));
+
+typedef struct Font Font;
+
+// TrueType or OpenType fonts, read with stb_truetype. The file stays mapped until DestroyFont.
+Font *LoadFontFromFile(const char *filename);
+void DestroyFont(Font *font);
+
+// UTF-8 text with '\n' line breaks. size is the em size in pixels, rounded to whole pixels, and position is
+// the top left of the first line. Glyphs are rasterized on first use into a shared atlas and drawn in the
+// sprite batch, one draw per atlas page. Layouts are cached per font, size and string.
+void RenderText(Font *font, const char *text, glm::vec2 position, float size, glm::vec4 color = glm::vec4(1.0f));
+glm::vec2 MeasureText(Font *font, const char *text, float size);
+
+// Everything in pixels at the drawn size. Outlines grow outward from the glyph edge, and the shadow is a
+// copy of the outlined text drawn behind it. Outlines and shadows reach at most MSDF_RANGE texels of the
+// distance field past the edge (see src/Font.h), so wide ones need large text.
+struct TextStyle
+{
+    float outlineWidth = 0.0f;
+    glm::vec4 outlineColor = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+
+    glm::vec2 shadowOffset = glm::vec2(0.0f);
+    float shadowSoftness = 0.0f;
+    glm::vec4 shadowColor = glm::vec4(0.0f);    // No shadow while transparent
+};
+
+// Like RenderText, but from multi-channel signed distance fields that are generated once per glyph on the
+// job workers and shared by every size, so text stays sharp at any size, position and zoom without being
+// rasterized again. Layouts are not snapped to pixels.
+void RenderSdfText(Font *font, const char *text, glm::vec2 position, float size, glm::vec4 color = glm::vec4(1.0f), const TextStyle &style = {});
+glm::vec2 MeasureSdfText(Font *font, const char *text, float size);
+
 #define RENDER_TO_SCREEN (Texture *)nullptr
 
 void SetRenderTarget(Texture *texture);
\ No newline at end of file
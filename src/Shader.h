@@ -1,5 +1,6 @@
 #pragma once
 
+#include <string>
 #include <vector>
 
 #include <volk.h>
@@ -10,6 +11,19 @@ struct DescriptorSetData
     uint32_t setIndex;
 };
 
+struct UniformMember
+{
+    std::string name;
+
+    uint32_t set;
+    uint32_t binding;
+
+    uint32_t offset;
+    uint32_t size;
+    uint32_t components;
+    bool integer;
+};
+
 struct Shader
 {
     std::vector<VkPipelineShaderStageCreateInfo> stages;
@@ -18,7 +32,36 @@ struct Shader
 
     std::vector<DescriptorSetData> sets;
     std::vector<VkPushConstantRange> ranges;
+
+    std::vector<UniformMember> uniforms;    // Members of every uniform block, from either stage
+
+    uint32_t specConstantMask;  // constant_ids declared by any stage, see PipelineKey::specialization
+};
+
+// Boolean specialization constants of the built-in shaders, bit n is constant_id n. Features a
+// shader doesn't declare are ignored, so one value can be used with every pipeline.
+enum ShaderFeature
+{
+    ShaderFeatureAlphaTest = 1 << 0     // Discards texels below half coverage, for cutouts drawn with BlendModeOpaque
+};
+
+struct ShaderSource
+{
+    const char *vertPath;
+    const char *fragPath;
+
+    const char *defines;    // Optional, inserted after #version in both stages, e.g. "#define TEXTURED 1\n"
 };
 
 void CreateShader(Shader *shader, const char *vertPath, const char *fragPath);
+
+// Leaves the shader untouched and fills log when either stage fails to load or compile
+bool TryCreateShader(Shader *shader, const char *vertPath, const char *fragPath, std::string *log);
+
+// Loads or compiles every stage of every shader across the job system. All or nothing, if any stage
+// fails none of the shaders are touched and log holds every error.
+bool TryCreateShaders(Shader *shaders, const ShaderSource *sources, uint32_t count, std::string *log);
+
+// Names are file names inside res/shaders, only available when built with VK2D_EMBED_SHADERS
+void CreateShaderFromEmbedded(Shader *shader, const char *vertName, const char *fragName);
 void DestroyShader(Shader *shader);
\ No newline at end of file
@@ -0,0 +1,198 @@
+#include "ShaderCache.h"
+
+#include "Utils.h"
+
+#include <SPIRV/GlslangToSpv.h>
+
+#include <atomic>
+#include <fstream>
+#include <mutex>
+
+#define SHADER_CACHE_DIR "shadercache"
+
+#define SHADER_CACHE_MAGIC 0x56505332 // "2SPV"
+#define SHADER_CACHE_VERSION 1
+
+// Entry layout: header, then per include a ShaderCacheInclude followed by its path padded to 8
+// bytes, then the SPIR-V words at spirvOffset
+struct ShaderCacheHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    uint64_t key;
+
+    uint32_t includeCount;
+    uint32_t spirvOffset;
+    uint32_t spirvSize;
+    uint32_t reserved;
+};
+
+struct ShaderCacheInclude
+{
+    uint64_t hash;
+    uint32_t pathLength;
+    uint32_t reserved;
+};
+
+static std::once_flag createDirectory;
+
+static std::string GetCachePath(uint64_t key)
+{
+    char name[32];
+    snprintf(name, sizeof(name), "%016llx.spv", (unsigned long long)key);
+
+    return std::string(SHADER_CACHE_DIR "/") + name;
+}
+
+static bool ReadFileHash(const std::string &path, uint64_t *hash)
+{
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open())
+        return false;
+
+    std::string contents((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    *hash = HashMemory(contents.data(), contents.size());
+
+    return true;
+}
+
+uint64_t GetShaderCacheKey(const std::string &source, const std::string &path, const std::string &defines)
+{
+    // Includes resolve relative to the shader, so identical sources in different directories can differ
+    size_t found = path.find_last_of("/\\");
+    std::string directory = found == std::string::npos ? "" : path.substr(0, found);
+
+    // The stage comes from the extension
+    size_t dot = path.rfind('.');
+    std::string stage = dot == std::string::npos ? "" : path.substr(dot + 1);
+
+    uint32_t version[2] = { SHADER_CACHE_VERSION, (uint32_t)glslang::GetSpirvGeneratorVersion() };
+
+    uint64_t key = HashMemory(version, sizeof(version));
+    key = HashMemory(source.data(), source.size(), key);
+    key = HashMemory(stage.data(), stage.size(), key);
+    key = HashMemory(directory.data(), directory.size(), key);
+    key = HashMemory(defines.data(), defines.size(), key);
+
+    return key;
+}
+
+bool LoadCachedSpirv(uint64_t key, SpirvBinary *binary)
+{
+    MappedFile file = {};
+    if (!PlatformMapFile(&file, GetCachePath(key).c_str()))
+        return false;
+
+    const ShaderCacheHeader *header = (const ShaderCacheHeader *)file.data;
+
+    bool valid = file.size >= sizeof(ShaderCacheHeader) &&
+        header->magic == SHADER_CACHE_MAGIC &&
+        header->version == SHADER_CACHE_VERSION &&
+        header->key == key &&
+        header->spirvOffset % 4 == 0 &&
+        header->spirvSize % 4 == 0 &&
+        (uint64_t)header->spirvOffset + header->spirvSize <= file.size;
+
+    size_t offset = sizeof(ShaderCacheHeader);
+    for (uint32_t i = 0; valid && i < header->includeCount; ++i)
+    {
+        if (offset + sizeof(ShaderCacheInclude) > header->spirvOffset)
+        {
+            valid = false;
+            break;
+        }
+
+        const ShaderCacheInclude *include = (const ShaderCacheInclude *)(file.data + offset);
+        offset += sizeof(ShaderCacheInclude);
+
+        if (offset + include->pathLength > header->spirvOffset)
+        {
+            valid = false;
+            break;
+        }
+
+        std::string path((const char *)file.data + offset, include->pathLength);
+        offset += (include->pathLength + 7) & ~7u;
+
+        uint64_t hash;
+        valid = ReadFileHash(path, &hash) && hash == include->hash;
+    }
+
+    if (!valid)
+    {
+        PlatformUnmapFile(&file);
+        return false;
+    }
+
+    binary->code = (const uint32_t *)(file.data + header->spirvOffset);
+    binary->size = header->spirvSize;
+    binary->mapped = true;
+    binary->file = file;
+
+    return true;
+}
+
+void StoreCachedSpirv(uint64_t key, const std::vector<ShaderInclude> &includes, const std::vector<uint32_t> &spirv)
+{
+    std::call_once(createDirectory, []() { PlatformCreateDirectory(SHADER_CACHE_DIR); });
+
+    std::vector<uint8_t> data(sizeof(ShaderCacheHeader));
+
+    for (const ShaderInclude &include : includes)
+    {
+        ShaderCacheInclude record = {};
+        record.hash = include.hash;
+        record.pathLength = (uint32_t)include.path.size();
+
+        size_t offset = data.size();
+        data.resize(offset + sizeof(ShaderCacheInclude) + ((record.pathLength + 7) & ~7u));
+
+        memcpy(data.data() + offset, &record, sizeof(record));
+        memcpy(data.data() + offset + sizeof(record), include.path.data(), record.pathLength);
+    }
+
+    ShaderCacheHeader header = {};
+    header.magic = SHADER_CACHE_MAGIC;
+    header.version = SHADER_CACHE_VERSION;
+    header.key = key;
+    header.includeCount = (uint32_t)includes.size();
+    header.spirvOffset = (uint32_t)data.size();
+    header.spirvSize = (uint32_t)(spirv.size() * sizeof(uint32_t));
+
+    memcpy(data.data(), &header, sizeof(header));
+
+    data.resize(data.size() + header.spirvSize);
+    memcpy(data.data() + header.spirvOffset, spirv.data(), header.spirvSize);
+
+    // Written under a temporary name first so a crash never leaves a truncated entry behind. Each writer
+    // gets its own name, workers compiling the same shader at once would otherwise interleave their writes.
+    static std::atomic<uint32_t> tempCounter(0);
+
+    std::string path = GetCachePath(key);
+    std::string tempPath = path + "." + std::to_string(tempCounter++) + ".tmp";
+
+    {
+        std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+        if (!file.is_open())
+        {
+            printf("Failed to write shader cache entry: %s\n", tempPath.c_str());
+            return;
+        }
+
+        file.write((const char *)data.data(), data.size());
+    }
+
+    if (!PlatformReplaceFile(tempPath.c_str(), path.c_str()))
+        printf("Failed to write shader cache entry: %s\n", path.c_str());
+}
+
+void ReleaseSpirv(SpirvBinary *binary)
+{
+    if (binary->mapped)
+        PlatformUnmapFile(&binary->file);
+
+    binary->compiled.clear();
+    binary->code = nullptr;
+    binary->size = 0;
+    binary->mapped = false;
+}
\ No newline at end of file
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+#include "Internal.h"
+#include "GlslCompiler.h"
+
+// SPIR-V either compiled this run or mapped straight out of the on-disk cache
+struct SpirvBinary
+{
+    const uint32_t *code;
+    size_t size;    // In bytes
+
+    std::vector<uint32_t> compiled;
+
+    bool mapped;
+    MappedFile file;
+};
+
+// Covers everything that changes the compiler output except includes, which are only known after
+// compiling and are checked against their recorded hashes on lookup instead
+uint64_t GetShaderCacheKey(const std::string &source, const std::string &path, const std::string &defines);
+
+// Fails on a miss, a corrupt entry, or when any recorded include changed since the entry was written
+bool LoadCachedSpirv(uint64_t key, SpirvBinary *binary);
+void StoreCachedSpirv(uint64_t key, const std::vector<ShaderInclude> &includes, const std::vector<uint32_t> &spirv);
+
+void ReleaseSpirv(SpirvBinary *binary);
\ No newline at end of file
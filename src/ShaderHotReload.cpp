@@ -0,0 +1,292 @@
+#include "ShaderHotReload.h"
+
+#include "Renderer.h"
+#include "Internal.h"
+#include "Utils.h"
+#include "JobSystem.h"
+
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Editors tend to save in several steps, give them a moment before reading the files
+#define RELOAD_SETTLE_MS 50
+
+struct ReloadablePipeline
+{
+    GraphicsPipeline *pipeline;
+
+    std::string vertPath;
+    std::string fragPath;
+    std::string defines;
+
+    ShaderReloadCallback prepare;
+};
+
+struct PendingPipeline
+{
+    GraphicsPipeline *target;
+    GraphicsPipeline pipeline;
+};
+
+struct ShaderHotReload
+{
+    std::vector<ReloadablePipeline> pipelines;
+
+    bool watching;
+    FileWatcher watcher;
+    std::thread thread;
+
+    // Guards pipelines as well, shader variants register while the watcher runs
+    std::mutex mutex;
+    std::vector<PendingPipeline> pending;
+};
+
+static ShaderHotReload hotReload;
+
+static std::string GetFileName(const std::string &path)
+{
+    size_t found = path.find_last_of("/\\");
+    return found == std::string::npos ? path : path.substr(found + 1);
+}
+
+static bool IsShaderFile(const std::string &name)
+{
+    size_t dot = name.rfind('.');
+    if (dot == std::string::npos)
+        return false;
+
+    std::string extension = name.substr(dot + 1);
+    return extension == "vert" || extension == "frag" || extension == "glsl";
+}
+
+static bool IsRegistered(GraphicsPipeline *pipeline)
+{
+    for (const ReloadablePipeline &reloadable : hotReload.pipelines)
+    {
+        if (reloadable.pipeline == pipeline)
+            return true;
+    }
+
+    return false;
+}
+
+static void RebuildPipeline(const ReloadablePipeline &reloadable)
+{
+    Shader shader = {};
+    std::string log;
+
+    ShaderSource source = { reloadable.vertPath.c_str(), reloadable.fragPath.c_str(), reloadable.defines.c_str() };
+
+    // A broken shader keeps the last working pipeline on screen
+    if (!TryCreateShaders(&shader, &source, 1, &log))
+    {
+        printf("Shader reload failed, keeping the previous pipeline:\n%s\n", log.c_str());
+        return;
+    }
+
+    if (reloadable.prepare && !reloadable.prepare(&shader, &log))
+    {
+        printf("Shader reload rejected, keeping the previous pipeline:\n%s\n", log.c_str());
+
+        DestroyShader(&shader);
+        return;
+    }
+
+    PendingPipeline pending = {};
+    pending.target = reloadable.pipeline;
+    CreateGraphicsPipeline(&pending.pipeline, &shader);
+
+    // New SPIR-V always misses the pipeline cache, so the variants in use are built here rather than
+    // stalling the render thread on the first draw after the swap
+    std::vector<PipelineKey> keys;
+    {
+        std::lock_guard<std::mutex> lock(hotReload.mutex);
+
+        // Registration keeps the target alive while its keys are read
+        if (IsRegistered(pending.target))
+            keys = GetPipelineVariantKeys(pending.target);
+    }
+
+    std::vector<PipelineVariantRequest> requests(keys.size());
+    for (size_t i = 0; i < keys.size(); ++i)
+    {
+        requests[i] = { &pending.pipeline, keys[i] };
+    }
+
+    VkResult result = CreatePipelineVariants(requests.data(), (uint32_t)requests.size());
+    if (result != VK_SUCCESS)
+    {
+        printf("Shader reload failed to create pipelines, keeping the previous pipeline: %s\n", GetVkResultString(result));
+
+        DestroyGraphicsPipeline(&pending.pipeline);
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(hotReload.mutex);
+
+        // Unregistered while it was rebuilding, the target may already be gone
+        if (!IsRegistered(pending.target))
+        {
+            DestroyGraphicsPipeline(&pending.pipeline);
+            return;
+        }
+
+        hotReload.pending.push_back(pending);
+    }
+}
+
+static void WatchShaders()
+{
+    std::vector<std::string> changed;
+
+    while (PlatformWaitForFileChanges(&hotReload.watcher, &changed))
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(RELOAD_SETTLE_MS));
+
+        // Includes are not tracked per pipeline, so touching one (or losing events) rebuilds everything
+        bool rebuildAll = changed.empty();
+        std::vector<std::string> shaders;
+
+        for (const std::string &name : changed)
+        {
+            if (!IsShaderFile(name))
+                continue;
+
+            if (name.substr(name.rfind('.') + 1) == "glsl")
+                rebuildAll = true;
+
+            shaders.push_back(name);
+        }
+
+        if (!rebuildAll && shaders.empty())
+            continue;
+
+        std::vector<ReloadablePipeline> pipelines;
+        {
+            std::lock_guard<std::mutex> lock(hotReload.mutex);
+            pipelines = hotReload.pipelines;
+        }
+
+        std::vector<const ReloadablePipeline *> affected;
+        for (const ReloadablePipeline &reloadable : pipelines)
+        {
+            bool matches = rebuildAll;
+            for (const std::string &name : shaders)
+            {
+                matches |= name == GetFileName(reloadable.vertPath) || name == GetFileName(reloadable.fragPath);
+            }
+
+            if (matches)
+                affected.push_back(&reloadable);
+        }
+
+        // Touching a shared include rebuilds everything, spread it over the job system
+        ParallelFor((uint32_t)affected.size(), 1, [&](uint32_t begin, uint32_t end)
+        {
+            for (uint32_t i = begin; i < end; ++i)
+            {
+                RebuildPipeline(*affected[i]);
+            }
+        });
+    }
+}
+
+void RegisterReloadablePipeline(GraphicsPipeline *pipeline, const char *vertPath, const char *fragPath, const char *defines /* = nullptr */, ShaderReloadCallback prepare /* = nullptr */)
+{
+    std::lock_guard<std::mutex> lock(hotReload.mutex);
+
+    hotReload.pipelines.push_back({ pipeline, vertPath, fragPath, defines ? defines : "", prepare });
+}
+
+void UnregisterReloadablePipeline(GraphicsPipeline *pipeline)
+{
+    std::lock_guard<std::mutex> lock(hotReload.mutex);
+
+    for (size_t i = 0; i < hotReload.pipelines.size(); ++i)
+    {
+        if (hotReload.pipelines[i].pipeline == pipeline)
+        {
+            hotReload.pipelines.erase(hotReload.pipelines.begin() + i);
+            break;
+        }
+    }
+
+    // Rebuilt but never swapped in, nothing has recorded them yet
+    for (size_t i = 0; i < hotReload.pending.size();)
+    {
+        if (hotReload.pending[i].target == pipeline)
+        {
+            DestroyGraphicsPipeline(&hotReload.pending[i].pipeline);
+            hotReload.pending.erase(hotReload.pending.begin() + i);
+        }
+        else
+        {
+            ++i;
+        }
+    }
+}
+
+void StartShaderHotReload(const char *directory)
+{
+    if (hotReload.watching)
+        return;
+
+    if (!PlatformWatchDirectory(&hotReload.watcher, directory))
+    {
+        printf("Failed to watch shader directory: %s\n", directory);
+        return;
+    }
+
+    hotReload.watching = true;
+    hotReload.thread = std::thread(WatchShaders);
+}
+
+void StopShaderHotReload()
+{
+    if (!hotReload.watching)
+        return;
+
+    PlatformCancelFileWatch(&hotReload.watcher);
+    hotReload.thread.join();
+    PlatformCloseFileWatch(&hotReload.watcher);
+
+    hotReload.watching = false;
+
+    // Rebuilt but never swapped in, nothing has recorded them yet
+    for (PendingPipeline &pending : hotReload.pending)
+    {
+        DestroyGraphicsPipeline(&pending.pipeline);
+    }
+
+    hotReload.pending.clear();
+}
+
+void ApplyShaderReloads()
+{
+    std::vector<PendingPipeline> pending;
+
+    {
+        std::lock_guard<std::mutex> lock(hotReload.mutex);
+        pending.swap(hotReload.pending);
+    }
+
+    for (PendingPipeline &swap : pending)
+    {
+        // The hot reload thread may be listing the target's variants for another rebuild
+        GraphicsPipeline old = swap.pipeline;
+        ReplaceGraphicsPipeline(swap.target, &old);
+
+        // Earlier frames may still be executing with the old pipeline
+        AcquireCurrentFrame().deletionQueue.push_back([=]() mutable
+        {
+            DestroyGraphicsPipeline(&old);
+        });
+    }
+
+    if (!pending.empty())
+        renderer.lastPipeline = VK_NULL_HANDLE;
+}
\ No newline at end of file
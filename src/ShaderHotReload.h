@@ -0,0 +1,24 @@
+#pragma once
+
+#include <volk.h>
+
+#include <functional>
+#include <string>
+
+#include "GraphicsPipeline.h"
+
+// Adjusts a freshly compiled shader before its pipeline is created, runs on a worker thread.
+// Returning false keeps the previous pipeline, with log printed.
+typedef std::function<bool (Shader *shader, std::string *log)> ShaderReloadCallback;
+
+// Pipelines registered here are rebuilt in the background when their shader sources change, their
+// variants are recreated lazily once the new shader is swapped in. A pipeline must be unregistered
+// before it is destroyed.
+void RegisterReloadablePipeline(GraphicsPipeline *pipeline, const char *vertPath, const char *fragPath, const char *defines = nullptr, ShaderReloadCallback prepare = nullptr);
+void UnregisterReloadablePipeline(GraphicsPipeline *pipeline);
+
+void StartShaderHotReload(const char *directory);
+void StopShaderHotReload();
+
+// Swaps in pipelines that finished rebuilding, called at the start of a frame
+void ApplyShaderReloads();
\ No newline at end of file
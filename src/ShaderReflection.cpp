@@ -0,0 +1,251 @@
+#include "ShaderReflection.h"
+
+#include "Shader.h"
+
+#include <spirv_reflect.h>
+
+#include <stdio.h>
+
+#include <algorithm>
+
+static uint32_t GetFormatSize(VkFormat format)
+{
+    switch (format)
+    {
+        case VK_FORMAT_R32_SFLOAT: return 1 * 4;
+        case VK_FORMAT_R32_UINT: return 1 * 4;
+        case VK_FORMAT_R32_SINT: return 1 * 4;
+        case VK_FORMAT_R32G32_SFLOAT: return 2 * 4;
+        case VK_FORMAT_R32G32B32_SFLOAT: return 3 * 4;
+        case VK_FORMAT_R32G32B32A32_SFLOAT: return 4 * 4;
+        default: return 0;
+    }
+}
+
+bool ReflectSpirv(const uint32_t *code, size_t size, ShaderReflection *reflection, ReflectionStorage *storage)
+{
+    SpvReflectShaderModule spvModule;
+    if (spvReflectCreateShaderModule(size, code, &spvModule) != SPV_REFLECT_RESULT_SUCCESS)
+        return false;
+
+    *reflection = {};
+    storage->attributes.clear();
+    storage->bindings.clear();
+    storage->members.clear();
+    storage->names.clear();
+
+    reflection->stage = (VkShaderStageFlagBits)spvModule.shader_stage;
+
+    if (reflection->stage == VK_SHADER_STAGE_VERTEX_BIT)
+    {
+        uint32_t inCount = 0;
+        spvReflectEnumerateInputVariables(&spvModule, &inCount, nullptr);
+        std::vector<SpvReflectInterfaceVariable *> vars(inCount);
+        spvReflectEnumerateInputVariables(&spvModule, &inCount, vars.data());
+
+        // Attributes are packed in location order, the enumeration order isn't guaranteed to match
+        std::sort(vars.begin(), vars.end(), [](const SpvReflectInterfaceVariable *a, const SpvReflectInterfaceVariable *b)
+        {
+            return a->location < b->location;
+        });
+
+        uint32_t offset = 0;
+
+        for (uint32_t i = 0; i < inCount; ++i)
+        {
+            SpvReflectInterfaceVariable &var = *(vars[i]);
+            if (var.built_in == -1)
+            {
+                ReflectedAttribute attribute = {};
+                attribute.location = var.location;
+                attribute.format = (VkFormat)var.format;
+                attribute.offset = offset;
+
+                storage->attributes.push_back(attribute);
+
+                offset += GetFormatSize(attribute.format);
+            }
+        }
+
+        reflection->vertexStride = offset;
+    }
+
+    uint32_t setCount = 0;
+    spvReflectEnumerateDescriptorSets(&spvModule, &setCount, nullptr);
+    std::vector<SpvReflectDescriptorSet *> sets(setCount);
+    spvReflectEnumerateDescriptorSets(&spvModule, &setCount, sets.data());
+
+    reflection->setCount = setCount;
+
+    for (uint32_t i = 0; i < setCount; ++i)
+    {
+        SpvReflectDescriptorSet &set = *(sets[i]);
+
+        for (uint32_t j = 0; j < set.binding_count; ++j)
+        {
+            SpvReflectDescriptorBinding &binding = *(set.bindings[j]);
+
+            ReflectedBinding reflected = {};
+            reflected.set = set.set;
+            reflected.binding = binding.binding;
+            reflected.type = (VkDescriptorType)binding.descriptor_type;
+            reflected.count = 1;
+            for (uint32_t dims = 0; dims < binding.array.dims_count; ++dims)
+            {
+                reflected.count *= binding.array.dims[dims];
+            }
+
+            storage->bindings.push_back(reflected);
+
+            if (reflected.type != VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER)
+                continue;
+
+            for (uint32_t k = 0; k < binding.block.member_count; ++k)
+            {
+                const SpvReflectBlockVariable &variable = binding.block.members[k];
+                const SpvReflectNumericTraits &numeric = variable.numeric;
+
+                storage->names.push_back(variable.name ? variable.name : "");
+
+                ReflectedMember member = {};
+                member.name = storage->names.back().c_str();
+                member.set = set.set;
+                member.binding = binding.binding;
+                member.offset = variable.offset;
+                member.size = variable.size;
+                member.integer = variable.type_description && (variable.type_description->type_flags & SPV_REFLECT_TYPE_FLAG_INT);
+
+                if (numeric.matrix.column_count > 0)
+                    member.components = numeric.matrix.column_count * numeric.matrix.row_count;
+                else
+                    member.components = numeric.vector.component_count > 0 ? numeric.vector.component_count : 1;
+
+                storage->members.push_back(member);
+            }
+        }
+    }
+
+    uint32_t pushCount = 0;
+    spvReflectEnumeratePushConstantBlocks(&spvModule, &pushCount, nullptr);
+    std::vector<SpvReflectBlockVariable *> pushVars(pushCount);
+    spvReflectEnumeratePushConstantBlocks(&spvModule, &pushCount, pushVars.data());
+
+    for (uint32_t i = 0; i < pushCount; ++i)
+    {
+        reflection->pushConstantSize += pushVars[i]->size;
+    }
+
+    uint32_t specCount = 0;
+    spvReflectEnumerateSpecializationConstants(&spvModule, &specCount, nullptr);
+    std::vector<SpvReflectSpecializationConstant *> specConstants(specCount);
+    spvReflectEnumerateSpecializationConstants(&spvModule, &specCount, specConstants.data());
+
+    for (uint32_t i = 0; i < specCount; ++i)
+    {
+        uint32_t id = specConstants[i]->constant_id;
+        if (id >= 32)
+        {
+            printf("Specialization constant %s uses constant_id %u, only 0 to 31 can be set\n", specConstants[i]->name ? specConstants[i]->name : "", id);
+            continue;
+        }
+
+        reflection->specConstantMask |= 1u << id;
+    }
+
+    spvReflectDestroyShaderModule(&spvModule);
+
+    reflection->attributes = storage->attributes.data();
+    reflection->attributeCount = (uint32_t)storage->attributes.size();
+    reflection->bindings = storage->bindings.data();
+    reflection->bindingCount = (uint32_t)storage->bindings.size();
+    reflection->members = storage->members.data();
+    reflection->memberCount = (uint32_t)storage->members.size();
+
+    return true;
+}
+
+void ApplyShaderReflection(Shader *shader, const ShaderReflection &reflection)
+{
+    if (reflection.stage == VK_SHADER_STAGE_VERTEX_BIT)
+    {
+        for (uint32_t i = 0; i < reflection.attributeCount; ++i)
+        {
+            VkVertexInputAttributeDescription attribute = {};
+            attribute.binding = 0;
+            attribute.location = reflection.attributes[i].location;
+            attribute.format = reflection.attributes[i].format;
+            attribute.offset = reflection.attributes[i].offset;
+
+            shader->descriptions.push_back(attribute);
+        }
+
+        VkVertexInputBindingDescription &binding = shader->binding;
+        binding.binding = 0;
+        binding.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+        binding.stride = reflection.vertexStride;
+    }
+
+    // Sets are indexed by number, so unused numbers below the highest one get an empty entry
+    for (uint32_t i = 0; i < reflection.bindingCount; ++i)
+    {
+        uint32_t setIndex = reflection.bindings[i].set;
+        if (setIndex >= shader->sets.size())
+            shader->sets.resize(setIndex + 1);
+    }
+
+    // A binding used by both stages is merged into one with both stage flags
+    for (uint32_t i = 0; i < reflection.bindingCount; ++i)
+    {
+        const ReflectedBinding &binding = reflection.bindings[i];
+
+        DescriptorSetData &data = shader->sets[binding.set];
+        data.setIndex = binding.set;
+
+        VkDescriptorSetLayoutBinding *setBinding = nullptr;
+        for (VkDescriptorSetLayoutBinding &existing : data.bindings)
+        {
+            if (existing.binding == binding.binding)
+                setBinding = &existing;
+        }
+
+        if (!setBinding)
+        {
+            data.bindings.push_back({});
+
+            setBinding = &data.bindings.back();
+            setBinding->binding = binding.binding;
+            setBinding->descriptorType = binding.type;
+            setBinding->pImmutableSamplers = nullptr;
+            setBinding->descriptorCount = binding.count;
+        }
+
+        setBinding->stageFlags |= reflection.stage;
+    }
+
+    for (uint32_t i = 0; i < reflection.memberCount; ++i)
+    {
+        const ReflectedMember &reflected = reflection.members[i];
+
+        bool found = false;
+        for (const UniformMember &member : shader->uniforms)
+        {
+            found |= member.set == reflected.set && member.binding == reflected.binding && member.name == reflected.name;
+        }
+
+        if (!found)
+            shader->uniforms.push_back({ reflected.name, reflected.set, reflected.binding, reflected.offset, reflected.size, reflected.components, reflected.integer });
+    }
+
+    shader->specConstantMask |= reflection.specConstantMask;
+
+    if (shader->ranges.capacity() != 1)
+        shader->ranges.resize(1);
+
+    if (reflection.pushConstantSize > 0)
+    {
+        VkPushConstantRange &range = shader->ranges[0];
+        range.stageFlags |= reflection.stage;
+        range.size = reflection.pushConstantSize;
+        range.offset = 0;
+    }
+}
\ No newline at end of file
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <stdint.h>
+
+#include <deque>
+#include <string>
+#include <vector>
+
+#include <volk.h>
+
+struct Shader;
+
+struct ReflectedAttribute
+{
+    uint32_t location;
+    VkFormat format;
+    uint32_t offset;
+};
+
+struct ReflectedBinding
+{
+    uint32_t set;
+    uint32_t binding;
+    VkDescriptorType type;
+    uint32_t count;
+};
+
+// A member of a uniform block, so parameters can be set by name
+struct ReflectedMember
+{
+    const char *name;
+
+    uint32_t set;
+    uint32_t binding;
+
+    uint32_t offset;
+    uint32_t size;          // In bytes
+    uint32_t components;    // 1 to 4 for scalars and vectors, columns * rows for matrices
+    bool integer;
+};
+
+// Plain data so vk2d-shaderc can emit it as static tables next to the embedded SPIR-V
+struct ShaderReflection
+{
+    VkShaderStageFlagBits stage;
+
+    const ReflectedAttribute *attributes;
+    uint32_t attributeCount;
+    uint32_t vertexStride;
+
+    const ReflectedBinding *bindings;   // Grouped by set, in reflection order
+    uint32_t bindingCount;
+    uint32_t setCount;
+
+    uint32_t pushConstantSize;
+
+    uint32_t specConstantMask;  // Bit n set when the stage declares constant_id n, ids past 31 are unsupported
+
+    const ReflectedMember *members;     // Top level members of every uniform block
+    uint32_t memberCount;
+};
+
+// SPIR-V and reflection compiled into the binary by vk2d-shaderc, see EmbeddedShaders.h in the build tree
+struct EmbeddedShader
+{
+    const char *name;   // File name, e.g. "texture.vert"
+
+    const uint32_t *code;
+    size_t size;        // In bytes
+
+    ShaderReflection reflection;
+};
+
+// Backing arrays for a reflection produced at runtime
+struct ReflectionStorage
+{
+    std::vector<ReflectedAttribute> attributes;
+    std::vector<ReflectedBinding> bindings;
+    std::vector<ReflectedMember> members;
+
+    std::deque<std::string> names;     // Member names, a deque so they never move
+};
+
+bool ReflectSpirv(const uint32_t *code, size_t size, ShaderReflection *reflection, ReflectionStorage *storage);
+
+// Adds one stage's vertex input, descriptor sets and push constants to the shader
+void ApplyShaderReflection(Shader *shader, const ShaderReflection &reflection);
\ No newline at end of file
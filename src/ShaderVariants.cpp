@@ -0,0 +1,75 @@
+#include "ShaderVariants.h"
+
+#include "Internal.h"
+#include "Utils.h"
+#include "ShaderHotReload.h"
+
+#include <assert.h>
+
+void CreateShaderVariantSet(ShaderVariantSet *set, const char *vertPath, const char *fragPath, const char *const *features, uint32_t featureCount)
+{
+    assert(featureCount <= 32 && "Feature masks are 32 bit");
+
+    set->vertPath = vertPath;
+    set->fragPath = fragPath;
+
+    set->features.assign(features, features + featureCount);
+    set->variants.clear();
+}
+
+void DestroyShaderVariantSet(ShaderVariantSet *set)
+{
+    for (auto &variant : set->variants)
+    {
+        GraphicsPipeline *pipeline = variant.second;
+        if (!pipeline)
+            continue;
+
+        UnregisterReloadablePipeline(pipeline);
+
+        AcquireCurrentFrame().deletionQueue.push_back([=]()
+        {
+            DestroyGraphicsPipeline(pipeline);
+            delete pipeline;
+        });
+    }
+
+    set->variants.clear();
+}
+
+GraphicsPipeline *GetShaderVariant(ShaderVariantSet *set, uint32_t featureMask)
+{
+    auto it = set->variants.find(featureMask);
+    if (it != set->variants.end())
+        return it->second;
+
+    ZoneScopedN("Compile shader variant");
+
+    std::string defines;
+    for (uint32_t i = 0; i < (uint32_t)set->features.size(); ++i)
+    {
+        if (featureMask & (1u << i))
+            defines += "#define " + set->features[i] + " 1\n";
+    }
+
+    Shader shader = {};
+    ShaderSource source = { set->vertPath.c_str(), set->fragPath.c_str(), defines.c_str() };
+
+    // Failures are remembered too, rather than recompiled by every draw that asks for them
+    std::string log;
+    if (!TryCreateShaders(&shader, &source, 1, &log))
+    {
+        printf("%s\n", log.c_str());
+
+        set->variants[featureMask] = nullptr;
+        return nullptr;
+    }
+
+    GraphicsPipeline *pipeline = new GraphicsPipeline();
+    CreateGraphicsPipeline(pipeline, &shader);
+    RegisterReloadablePipeline(pipeline, set->vertPath.c_str(), set->fragPath.c_str(), defines.c_str());
+
+    set->variants[featureMask] = pipeline;
+
+    return pipeline;
+}
\ No newline at end of file
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <stdint.h>
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "GraphicsPipeline.h"
+
+// One shader source compiled with different combinations of feature defines, so features can be
+// compiled out instead of branched on. Each combination is compiled the first time it is requested
+// and goes through the SPIR-V disk cache like any other shader.
+struct ShaderVariantSet
+{
+    std::string vertPath;
+    std::string fragPath;
+
+    std::vector<std::string> features;     // Bit n of a feature mask defines features[n] as 1
+
+    std::unordered_map<uint32_t, GraphicsPipeline *> variants;
+};
+
+void CreateShaderVariantSet(ShaderVariantSet *set, const char *vertPath, const char *fragPath, const char *const *features, uint32_t featureCount);
+void DestroyShaderVariantSet(ShaderVariantSet *set);
+
+// Null, with the compiler output printed once, when the combination fails to compile
+GraphicsPipeline *GetShaderVariant(ShaderVariantSet *set, uint32_t featureMask);
\ No newline at end of file
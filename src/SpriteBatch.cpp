@@ -0,0 +1,272 @@
+#include "SpriteBatch.h"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define SPRITE_KERNEL_X86
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#define SPRITE_KERNEL_AVX2
+#else
+#define SPRITE_KERNEL_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+#define UV_LOW_MASK 0x0000FFFFu
+
+static void ExpandSpritesScalar(const SpriteStream *stream, uint32_t begin, uint32_t end, BatchVertex *dst)
+{
+    for (uint32_t i = begin; i < end; ++i)
+    {
+        float c = stream->cosine[i];
+        float s = stream->sine[i];
+
+        float cl = c * stream->left[i];
+        float cr = c * stream->right[i];
+        float sl = s * stream->left[i];
+        float sr = s * stream->right[i];
+        float ct = c * stream->top[i];
+        float cb = c * stream->bottom[i];
+        float st = s * stream->top[i];
+        float sb = s * stream->bottom[i];
+
+        float x = stream->x[i];
+        float y = stream->y[i];
+
+        // The unit quad has the texture's v running opposite to y, sprites keep that convention
+        uint32_t texStart = stream->texStart[i];
+        uint32_t texEnd = stream->texEnd[i];
+
+        BatchVertex *out = dst + i * SPRITE_VERTEX_COUNT;
+        out[0] = { x + cl - st, y + sl + ct, (texStart & UV_LOW_MASK) | (texEnd & ~UV_LOW_MASK), stream->color[i] };
+        out[1] = { x + cr - st, y + sr + ct, texEnd, stream->color[i] };
+        out[2] = { x + cr - sb, y + sr + cb, (texEnd & UV_LOW_MASK) | (texStart & ~UV_LOW_MASK), stream->color[i] };
+        out[3] = { x + cl - sb, y + sl + cb, texStart, stream->color[i] };
+    }
+}
+
+#ifdef SPRITE_KERNEL_X86
+
+// Four sprites per iteration. Each corner is computed for all of them at once, then a 4x4 transpose
+// turns the x, y, uv and color rows into one vertex per sprite.
+static void ExpandSpritesSSE2(const SpriteStream *stream, BatchVertex *dst)
+{
+    const __m128i lowMask = _mm_set1_epi32((int)UV_LOW_MASK);
+
+    uint32_t i = 0;
+    for (; i + 4 <= stream->count; i += 4)
+    {
+        __m128 c = _mm_loadu_ps(stream->cosine + i);
+        __m128 s = _mm_loadu_ps(stream->sine + i);
+        __m128 left = _mm_loadu_ps(stream->left + i);
+        __m128 right = _mm_loadu_ps(stream->right + i);
+        __m128 top = _mm_loadu_ps(stream->top + i);
+        __m128 bottom = _mm_loadu_ps(stream->bottom + i);
+
+        __m128 x = _mm_loadu_ps(stream->x + i);
+        __m128 y = _mm_loadu_ps(stream->y + i);
+
+        __m128 cl = _mm_mul_ps(c, left);
+        __m128 cr = _mm_mul_ps(c, right);
+        __m128 sl = _mm_mul_ps(s, left);
+        __m128 sr = _mm_mul_ps(s, right);
+        __m128 ct = _mm_mul_ps(c, top);
+        __m128 cb = _mm_mul_ps(c, bottom);
+        __m128 st = _mm_mul_ps(s, top);
+        __m128 sb = _mm_mul_ps(s, bottom);
+
+        __m128i texStart = _mm_loadu_si128((const __m128i *)(stream->texStart + i));
+        __m128i texEnd = _mm_loadu_si128((const __m128i *)(stream->texEnd + i));
+        __m128 color = _mm_castsi128_ps(_mm_loadu_si128((const __m128i *)(stream->color + i)));
+
+        __m128 rows[4][4];
+        rows[0][0] = _mm_sub_ps(_mm_add_ps(x, cl), st);
+        rows[0][1] = _mm_add_ps(_mm_add_ps(y, sl), ct);
+        rows[0][2] = _mm_castsi128_ps(_mm_or_si128(_mm_and_si128(texStart, lowMask), _mm_andnot_si128(lowMask, texEnd)));
+        rows[1][0] = _mm_sub_ps(_mm_add_ps(x, cr), st);
+        rows[1][1] = _mm_add_ps(_mm_add_ps(y, sr), ct);
+        rows[1][2] = _mm_castsi128_ps(texEnd);
+        rows[2][0] = _mm_sub_ps(_mm_add_ps(x, cr), sb);
+        rows[2][1] = _mm_add_ps(_mm_add_ps(y, sr), cb);
+        rows[2][2] = _mm_castsi128_ps(_mm_or_si128(_mm_and_si128(texEnd, lowMask), _mm_andnot_si128(lowMask, texStart)));
+        rows[3][0] = _mm_sub_ps(_mm_add_ps(x, cl), sb);
+        rows[3][1] = _mm_add_ps(_mm_add_ps(y, sl), cb);
+        rows[3][2] = _mm_castsi128_ps(texStart);
+
+        // After the transpose rows[k][j] is corner k of sprite i + j
+        for (uint32_t k = 0; k < 4; ++k)
+        {
+            rows[k][3] = color;
+            _MM_TRANSPOSE4_PS(rows[k][0], rows[k][1], rows[k][2], rows[k][3]);
+        }
+
+        for (uint32_t j = 0; j < 4; ++j)
+        {
+            float *out = (float *)(dst + (i + j) * SPRITE_VERTEX_COUNT);
+            for (uint32_t k = 0; k < SPRITE_VERTEX_COUNT; ++k)
+            {
+                _mm_storeu_ps(out + k * 4, rows[k][j]);
+            }
+        }
+    }
+
+    ExpandSpritesScalar(stream, i, stream->count, dst);
+}
+
+// Transposes four rows of eight within each 128 bit lane, sprite j ends up in the low lane of
+// row j and sprite j + 4 in the high lane
+static inline SPRITE_KERNEL_AVX2 void Transpose4x4Lanes(__m256 *r0, __m256 *r1, __m256 *r2, __m256 *r3)
+{
+    __m256 t0 = _mm256_unpacklo_ps(*r0, *r1);
+    __m256 t1 = _mm256_unpacklo_ps(*r2, *r3);
+    __m256 t2 = _mm256_unpackhi_ps(*r0, *r1);
+    __m256 t3 = _mm256_unpackhi_ps(*r2, *r3);
+
+    *r0 = _mm256_shuffle_ps(t0, t1, _MM_SHUFFLE(1, 0, 1, 0));
+    *r1 = _mm256_shuffle_ps(t0, t1, _MM_SHUFFLE(3, 2, 3, 2));
+    *r2 = _mm256_shuffle_ps(t2, t3, _MM_SHUFFLE(1, 0, 1, 0));
+    *r3 = _mm256_shuffle_ps(t2, t3, _MM_SHUFFLE(3, 2, 3, 2));
+}
+
+static SPRITE_KERNEL_AVX2 void ExpandSpritesAVX2(const SpriteStream *stream, BatchVertex *dst)
+{
+    const __m256i lowMask = _mm256_set1_epi32((int)UV_LOW_MASK);
+
+    uint32_t i = 0;
+    for (; i + 8 <= stream->count; i += 8)
+    {
+        __m256 c = _mm256_loadu_ps(stream->cosine + i);
+        __m256 s = _mm256_loadu_ps(stream->sine + i);
+        __m256 left = _mm256_loadu_ps(stream->left + i);
+        __m256 right = _mm256_loadu_ps(stream->right + i);
+        __m256 top = _mm256_loadu_ps(stream->top + i);
+        __m256 bottom = _mm256_loadu_ps(stream->bottom + i);
+
+        __m256 x = _mm256_loadu_ps(stream->x + i);
+        __m256 y = _mm256_loadu_ps(stream->y + i);
+
+        __m256 cl = _mm256_mul_ps(c, left);
+        __m256 cr = _mm256_mul_ps(c, right);
+        __m256 sl = _mm256_mul_ps(s, left);
+        __m256 sr = _mm256_mul_ps(s, right);
+        __m256 ct = _mm256_mul_ps(c, top);
+        __m256 cb = _mm256_mul_ps(c, bottom);
+        __m256 st = _mm256_mul_ps(s, top);
+        __m256 sb = _mm256_mul_ps(s, bottom);
+
+        __m256i texStart = _mm256_loadu_si256((const __m256i *)(stream->texStart + i));
+        __m256i texEnd = _mm256_loadu_si256((const __m256i *)(stream->texEnd + i));
+        __m256 color = _mm256_castsi256_ps(_mm256_loadu_si256((const __m256i *)(stream->color + i)));
+
+        __m256 rows[4][4];
+        rows[0][0] = _mm256_sub_ps(_mm256_add_ps(x, cl), st);
+        rows[0][1] = _mm256_add_ps(_mm256_add_ps(y, sl), ct);
+        rows[0][2] = _mm256_castsi256_ps(_mm256_or_si256(_mm256_and_si256(texStart, lowMask), _mm256_andnot_si256(lowMask, texEnd)));
+        rows[1][0] = _mm256_sub_ps(_mm256_add_ps(x, cr), st);
+        rows[1][1] = _mm256_add_ps(_mm256_add_ps(y, sr), ct);
+        rows[1][2] = _mm256_castsi256_ps(texEnd);
+        rows[2][0] = _mm256_sub_ps(_mm256_add_ps(x, cr), sb);
+        rows[2][1] = _mm256_add_ps(_mm256_add_ps(y, sr), cb);
+        rows[2][2] = _mm256_castsi256_ps(_mm256_or_si256(_mm256_and_si256(texEnd, lowMask), _mm256_andnot_si256(lowMask, texStart)));
+        rows[3][0] = _mm256_sub_ps(_mm256_add_ps(x, cl), sb);
+        rows[3][1] = _mm256_add_ps(_mm256_add_ps(y, sl), cb);
+        rows[3][2] = _mm256_castsi256_ps(texStart);
+
+        for (uint32_t k = 0; k < 4; ++k)
+        {
+            rows[k][3] = color;
+            Transpose4x4Lanes(&rows[k][0], &rows[k][1], &rows[k][2], &rows[k][3]);
+        }
+
+        for (uint32_t j = 0; j < 4; ++j)
+        {
+            float *low = (float *)(dst + (i + j) * SPRITE_VERTEX_COUNT);
+            float *high = (float *)(dst + (i + j + 4) * SPRITE_VERTEX_COUNT);
+            for (uint32_t k = 0; k < SPRITE_VERTEX_COUNT; ++k)
+            {
+                __m256 vertex = rows[k][j];
+                _mm_storeu_ps(low + k * 4, _mm256_castps256_ps128(vertex));
+                _mm_storeu_ps(high + k * 4, _mm256_extractf128_ps(vertex, 1));
+            }
+        }
+    }
+
+    ExpandSpritesScalar(stream, i, stream->count, dst);
+}
+
+static bool IsAVX2Supported()
+{
+#ifdef _MSC_VER
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7)
+        return false;
+
+    // The OS also has to save the YMM registers across context switches
+    __cpuid(info, 1);
+    bool osxsave = (info[2] & (1 << 27)) != 0;
+    bool avx = (info[2] & (1 << 28)) != 0;
+    if (!osxsave || !avx || (_xgetbv(0) & 0x6) != 0x6)
+        return false;
+
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+
+#endif
+
+static SpriteKernelPath ResolvePath(SpriteKernelPath path)
+{
+    if (path != SpriteKernelPathBest)
+        return path;
+
+#ifdef SPRITE_KERNEL_X86
+    static SpriteKernelPath best = IsAVX2Supported() ? SpriteKernelPathAVX2 : SpriteKernelPathSSE2;
+    return best;
+#else
+    return SpriteKernelPathScalar;
+#endif
+}
+
+bool IsSpriteKernelPathSupported(SpriteKernelPath path)
+{
+    switch (path)
+    {
+        case SpriteKernelPathBest:
+        case SpriteKernelPathScalar:
+            return true;
+#ifdef SPRITE_KERNEL_X86
+        case SpriteKernelPathSSE2:
+            return true;
+        case SpriteKernelPathAVX2:
+            return IsAVX2Supported();
+#endif
+        default:
+            return false;
+    }
+}
+
+void ExpandSprites(const SpriteStream *stream, BatchVertex *dst, SpriteKernelPath path /* = SpriteKernelPathBest */)
+{
+    switch (ResolvePath(path))
+    {
+#ifdef SPRITE_KERNEL_X86
+        case SpriteKernelPathSSE2: ExpandSpritesSSE2(stream, dst); break;
+        case SpriteKernelPathAVX2: ExpandSpritesAVX2(stream, dst); break;
+#endif
+        default: ExpandSpritesScalar(stream, 0, stream->count, dst); break;
+    }
+}
+
+void WriteSpriteShapes(const SpriteStream *stream, BatchShapeData *dst)
+{
+    for (uint32_t i = 0; i < stream->count; ++i)
+    {
+        dst[i].halfWidth = (stream->right[i] - stream->left[i]) * 0.5f;
+        dst[i].halfHeight = (stream->bottom[i] - stream->top[i]) * 0.5f;
+        dst[i].shapeParams = stream->shapeParams[i];
+        dst[i].shape = stream->shape[i];
+    }
+}
\ No newline at end of file
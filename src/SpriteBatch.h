@@ -0,0 +1,87 @@
+#pragma once
+
+#include <stdint.h>
+
+// Sprites per batch, a full batch is flushed as one draw. Its vertices stay within 16 bit indices.
+#define SPRITE_BATCH_SIZE 4096
+#define SPRITE_VERTEX_COUNT 4
+#define SPRITE_INDEX_COUNT 6
+
+// Quads in a batch are either textured sprites or shapes evaluated as signed distances in
+// res/shaders/shape.frag. Shapes are drawn with the white texture and full uvs, and their quads
+// extend SHAPE_PADDING pixels past the shape on every side to leave room for the anti-aliased edge.
+// Distance field glyphs instead sample their field from the texture, see MsdfGlyph in src/Font.h.
+enum BatchShape
+{
+    BatchShapeSprite,
+    BatchShapeCircle,
+    BatchShapeRoundedRect,
+    BatchShapeMsdfGlyph
+};
+
+#define SHAPE_PADDING 1.0f
+
+// Vertex format of batched geometry, see res/shaders/sprite.vert
+struct BatchVertex
+{
+    float x;
+    float y;
+    uint32_t uv;        // 16 bit unorm u in the low half, v in the high half
+    uint32_t color;     // RGBA8 unorm, red in the lowest byte
+};
+
+// Per quad data of batches holding shapes, see res/shaders/shape.vert. Kept out of BatchVertex so plain
+// sprites don't pay for it, the shader finds a quad's record from its vertex index.
+struct BatchShapeData
+{
+    float halfWidth;
+    float halfHeight;
+    uint32_t shapeParams;   // Half floats, corner radius in the low half and outline thickness in the high half.
+                            // Glyphs have how far to grow the outline and the edge softness, in atlas texels.
+    uint32_t shape;         // BatchShape
+};
+
+// Queued sprites in SoA form, so the kernels can transform several sprites per instruction. The corner
+// extents are relative to the sprite's origin, a corner lands at (x, y) + rotate(corner).
+struct SpriteStream
+{
+    float x[SPRITE_BATCH_SIZE];
+    float y[SPRITE_BATCH_SIZE];
+    float cosine[SPRITE_BATCH_SIZE];
+    float sine[SPRITE_BATCH_SIZE];
+
+    float left[SPRITE_BATCH_SIZE];
+    float top[SPRITE_BATCH_SIZE];
+    float right[SPRITE_BATCH_SIZE];
+    float bottom[SPRITE_BATCH_SIZE];
+
+    // uv of the top left and bottom right corners, packed like BatchVertex::uv
+    uint32_t texStart[SPRITE_BATCH_SIZE];
+    uint32_t texEnd[SPRITE_BATCH_SIZE];
+
+    uint32_t color[SPRITE_BATCH_SIZE];
+
+    // Packed like BatchShapeData, shapeCount is how many quads aren't plain sprites
+    uint32_t shapeParams[SPRITE_BATCH_SIZE];
+    uint32_t shape[SPRITE_BATCH_SIZE];
+    uint32_t shapeCount;
+
+    uint32_t count;
+};
+
+enum SpriteKernelPath
+{
+    SpriteKernelPathBest,
+    SpriteKernelPathScalar,
+    SpriteKernelPathSSE2,
+    SpriteKernelPathAVX2
+};
+
+bool IsSpriteKernelPathSupported(SpriteKernelPath path);
+
+// Writes the corners of each sprite in the order top left, top right, bottom right, bottom left, for the
+// shared quad index buffer. dst is only written, so it can point straight at mapped vertex memory.
+void ExpandSprites(const SpriteStream *stream, BatchVertex *dst, SpriteKernelPath path = SpriteKernelPathBest);
+
+// Writes one record per sprite, only needed when the batch holds shapes
+void WriteSpriteShapes(const SpriteStream *stream, BatchShapeData *dst);
\ No newline at end of file
@@ -0,0 +1,38 @@
+#include "StagingRing.h"
+
+#include "Internal.h"
+#include "Utils.h"
+
+void CreateStagingRing(StagingRing *ring, uint32_t size, VkBufferUsageFlags usage /* = VK_BUFFER_USAGE_TRANSFER_SRC_BIT */, VmaMemoryUsage memoryUsage /* = VMA_MEMORY_USAGE_CPU_ONLY */)
+{
+    CreateBuffer(&ring->buffer, size, usage, memoryUsage);
+
+    ring->mapped = (uint8_t *)MapBufferMemory(&ring->buffer);
+    ring->offset = 0;
+}
+
+void DestroyStagingRing(StagingRing *ring)
+{
+    UnmapBufferMemory(&ring->buffer);
+    DestroyBuffer(&ring->buffer);
+
+    ring->mapped = nullptr;
+    ring->offset = 0;
+}
+
+bool StagingRingAllocate(StagingRing *ring, uint32_t size, uint32_t alignment, uint32_t *offset)
+{
+    uint32_t aligned = (ring->offset + alignment - 1) & ~(alignment - 1);
+    if (aligned + size > ring->buffer.size)
+        return false;
+
+    *offset = aligned;
+    ring->offset = aligned + size;
+
+    return true;
+}
+
+void ResetStagingRing(StagingRing *ring)
+{
+    ring->offset = 0;
+}
\ No newline at end of file
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <volk.h>
+
+#include "Buffer.h"
+
+// Per-frame linear allocator over a persistently mapped buffer, used for staging
+// uploads and for material parameters. Each frame in flight owns its rings, which
+// are rewound once that frame's fence has been waited on.
+struct StagingRing
+{
+    Buffer buffer;
+    uint8_t *mapped;
+
+    uint32_t offset;
+};
+
+struct StagingAllocation
+{
+    VkBuffer buffer;
+    uint32_t offset;
+
+    uint8_t *mapped;
+};
+
+void CreateStagingRing(StagingRing *ring, uint32_t size, VkBufferUsageFlags usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VmaMemoryUsage memoryUsage = VMA_MEMORY_USAGE_CPU_ONLY);
+void DestroyStagingRing(StagingRing *ring);
+
+bool StagingRingAllocate(StagingRing *ring, uint32_t size, uint32_t alignment, uint32_t *offset);
+void ResetStagingRing(StagingRing *ring);
\ No newline at end of file
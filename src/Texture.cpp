@@ -3,58 +3,253 @@
 #include "Renderer.h"
 #include "Internal.h"
 #include "Utils.h"
+#include "PixelConvert.h"
 
 #include <stb_image.h>
 
-Texture *CreateTexture(uint32_t width, uint32_t height)
+#include <assert.h>
+#include <ctype.h>
+#include <string.h>
+#include <string>
+
+VkFormat GetTextureVkFormat(TextureFormat format)
 {
-    _Texture *texture = (_Texture *)calloc(1, sizeof(_Texture));
+    switch (format)
+    {
+        case TextureFormatRGBA8: return VK_FORMAT_R8G8B8A8_SRGB;
+        case TextureFormatBGRA8: return VK_FORMAT_B8G8R8A8_SRGB;
+        case TextureFormatR8: return VK_FORMAT_R8_UNORM;
+        case TextureFormatRG8: return VK_FORMAT_R8G8_UNORM;
+        case TextureFormatRGBA16F: return VK_FORMAT_R16G16B16A16_SFLOAT;
+        case TextureFormatRGBA8Linear: return VK_FORMAT_R8G8B8A8_UNORM;
+        default:
+        {
+            assert(0 && "Unknown texture format");
+            return VK_FORMAT_UNDEFINED;
+        }
+    }
+}
+
+bool IsTextureFormatSupported(TextureFormat format, bool renderTarget /* = false */)
+{
+    VkFormatProperties properties = {};
+    vkGetPhysicalDeviceFormatProperties(renderer.physicalDevice, GetTextureVkFormat(format), &properties);
+
+    VkFormatFeatureFlags required = VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT | VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT | VK_FORMAT_FEATURE_TRANSFER_DST_BIT;
+    if (renderTarget)
+        required |= VK_FORMAT_FEATURE_COLOR_ATTACHMENT_BIT | VK_FORMAT_FEATURE_COLOR_ATTACHMENT_BLEND_BIT;
+
+    return (properties.optimalTilingFeatures & required) == required;
+}
+
+Texture *CreateTexture(uint32_t width, uint32_t height, TextureFormat format /* = TextureFormatRGBA8 */)
+{
+    Texture *handle;
+    _Texture *texture = AllocateTexture(&handle);
 
     texture->width = width;
     texture->height = height;
 
-    texture->format = VK_FORMAT_R8G8B8A8_SRGB;
+    texture->format = GetTextureVkFormat(format);
 
-    _CreateTexture(texture, width, height, texture->format, nullptr, VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT);
+    _CreateTexture(texture, width, height, texture->format, nullptr, VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT);
 
     VkFramebufferCreateInfo fboInfo = {};
     fboInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
     fboInfo.pNext = nullptr;
     fboInfo.flags = 0;
-    fboInfo.renderPass = renderer.toTexturePass;
+    fboInfo.renderPass = GetTargetRenderPass(texture->format);
     fboInfo.attachmentCount = 1;
-    fboInfo.pAttachments = &texture->view;
+    fboInfo.pAttachments = &texture->targetView;
     fboInfo.width = width;
     fboInfo.height = height;
     fboInfo.layers = 1;
 
     vkCreateFramebuffer(renderer.device, &fboInfo, nullptr, &texture->framebuffer);
 
-    return (Texture *)texture;
+    return handle;
+}
+
+// Separators unified, "." and ".." segments resolved, case folded on Windows
+static std::string NormalizeTexturePath(const char *filename)
+{
+    std::vector<std::string> segments;
+    bool absolute = filename[0] == '/' || filename[0] == '\\';
+
+    std::string segment;
+    for (const char *c = filename;; ++c)
+    {
+        if (*c == '/' || *c == '\\' || *c == '\0')
+        {
+            if (segment == "..")
+            {
+                if (!segments.empty() && segments.back() != "..")
+                    segments.pop_back();
+                else if (!absolute)
+                    segments.push_back(segment);
+            }
+            else if (!segment.empty() && segment != ".")
+            {
+                segments.push_back(segment);
+            }
+
+            segment.clear();
+
+            if (*c == '\0')
+                break;
+        }
+        else
+        {
+#ifdef _WIN32
+            segment += (char)tolower((unsigned char)*c);
+#else
+            segment += *c;
+#endif
+        }
+    }
+
+    std::string path = absolute ? "/" : "";
+    for (size_t i = 0; i < segments.size(); ++i)
+    {
+        if (i > 0)
+            path += '/';
+        path += segments[i];
+    }
+
+    return path;
+}
+
+// A hit has to match the whole entry, not just the key
+static Texture *FindCachedTexture(uint64_t key, const TextureCacheEntry &match)
+{
+    auto it = renderer.textureCache.find(key);
+    if (it == renderer.textureCache.end())
+        return nullptr;
+
+    const TextureCacheEntry &entry = it->second;
+    if (entry.path != match.path || entry.format != match.format || entry.flags != match.flags || entry.width != match.width || entry.height != match.height)
+        return nullptr;
+
+    if (entry.contentHash != match.contentHash)
+        return nullptr;
+
+    GetTexture(entry.texture)->refCount++;
+
+    return entry.texture;
 }
 
-Texture *LoadTextureFromPixels(uint32_t width, uint32_t height, uint8_t *pixels)
+static void AddCachedTexture(uint64_t key, Texture *handle, TextureCacheEntry &&entry)
 {
-    _Texture *texture = (_Texture *)calloc(1, sizeof(_Texture));
+    // A colliding key keeps its texture, the new one just isn't shared
+    if (renderer.textureCache.count(key))
+        return;
+
+    _Texture *texture = GetTexture(handle);
+    texture->cached = true;
+    texture->cacheKey = key;
+
+    TextureCacheEntry &stored = renderer.textureCache[key];
+    stored = std::move(entry);
+    stored.texture = handle;
+}
+
+// The contents no longer match the key, later loads get a fresh texture
+static void UncacheTexture(_Texture *texture)
+{
+    if (!texture->cached)
+        return;
+
+    renderer.textureCache.erase(texture->cacheKey);
+    texture->cached = false;
+}
+
+Texture *LoadTextureFromPixels(uint32_t width, uint32_t height, uint8_t *pixels, TextureFormat format /* = TextureFormatRGBA8 */, bool deduplicate /* = false */)
+{
+    uint64_t key = 0;
+    uint32_t size = width * height * GetFormatTexelSize(GetTextureVkFormat(format));
+
+    TextureCacheEntry entry = {};
+    entry.format = format;
+    entry.width = width;
+    entry.height = height;
+
+    if (deduplicate)
+    {
+        uint32_t header[3] = { width, height, (uint32_t)format };
+        key = HashMemory(pixels, size, HashMemory(header, sizeof(header)));
+        entry.contentHash = HashMemory(pixels, size, key);
+
+        if (Texture *cached = FindCachedTexture(key, entry))
+            return cached;
+    }
+
+    Texture *handle;
+    _Texture *texture = AllocateTexture(&handle);
 
     texture->width = width;
     texture->height = height;
     
-    texture->format = VK_FORMAT_R8G8B8A8_SRGB;
+    texture->format = GetTextureVkFormat(format);
 
     _CreateTexture(texture, width, height, texture->format, pixels, VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT);
 
     texture->framebuffer = VK_NULL_HANDLE;
 
-    return (Texture *)texture;
+    if (deduplicate)
+        AddCachedTexture(key, handle, std::move(entry));
+
+    return handle;
 }
 
-Texture *LoadTextureFromFile(const char *filename)
+Texture *LoadTextureFromFile(const char *filename, TextureFormat format /* = TextureFormatRGBA8 */, uint32_t flags /* = 0 */)
 {
-    _Texture *texture = (_Texture *)calloc(1, sizeof(_Texture));
+    std::string path = NormalizeTexturePath(filename);
+    uint64_t key = HashMemory(path.data(), path.size(), ((uint64_t)flags << 32) | ((uint64_t)format + 1));
+
+    TextureCacheEntry entry = {};
+    entry.path = path;
+    entry.format = format;
+    entry.flags = flags;
+
+    if (Texture *cached = FindCachedTexture(key, entry))
+        return cached;
+
+    int desiredChannels = 0;
+    switch (format)
+    {
+        case TextureFormatRGBA8: desiredChannels = 4; break;
+        case TextureFormatBGRA8: desiredChannels = 4; break;
+        case TextureFormatR8: desiredChannels = 1; break;
+        case TextureFormatRG8: desiredChannels = 2; break;
+        case TextureFormatRGBA8Linear: desiredChannels = 4; break;
+        default: break;
+    }
+
+    // stbi would fall back to the file's own channel count, which the upload size wouldn't match
+    if (desiredChannels == 0)
+    {
+        printf("Texture files can only be loaded as RGBA8, BGRA8, R8, RG8 or RGBA8Linear: %s\n", filename);
+        return nullptr;
+    }
+
+    // Images are stored top down, the renderer samples bottom up
+    uint32_t conversion = PixelConvertFlipY;
+    if (format == TextureFormatBGRA8)
+        conversion |= PixelConvertSwizzleRB;
+
+    if (flags & TextureLoadPremultiplyAlpha)
+    {
+        if (desiredChannels != 4)
+        {
+            printf("Only four channel textures can be premultiplied: %s\n", filename);
+            return nullptr;
+        }
+
+        conversion |= format == TextureFormatRGBA8Linear ? PixelConvertPremultiply : PixelConvertPremultiplySRGB;
+    }
 
     int width, height, channels;
-    stbi_uc *pixels = stbi_load(filename, &width, &height, &channels, 4);
+    stbi_uc *pixels = stbi_load(filename, &width, &height, &channels, desiredChannels);
 
     if (!pixels)
     {
@@ -62,59 +257,163 @@ Texture *LoadTextureFromFile(const char *filename)
         __debugbreak();
     }
 
+    Texture *handle;
+    _Texture *texture = AllocateTexture(&handle);
+
     texture->width = (uint32_t)width;
     texture->height = (uint32_t)height;
     
-    texture->format = VK_FORMAT_R8G8B8A8_SRGB;
+    texture->format = GetTextureVkFormat(format);
 
-    _CreateTexture(texture, texture->width, texture->height, texture->format, pixels, VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT);
+    _CreateTexture(texture, texture->width, texture->height, texture->format, pixels, VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, conversion);
 
     texture->framebuffer = VK_NULL_HANDLE;
 
     stbi_image_free(pixels);
 
-    return (Texture *)texture;
+    AddCachedTexture(key, handle, std::move(entry));
+
+    return handle;
 }
 
-void DestroyTexture(Texture *handle)
+static Texture *MakeTextureHandle(uint32_t index, uint32_t generation)
 {
-    vkDeviceWaitIdle(renderer.device);
+    static_assert(sizeof(Texture *) == sizeof(uint64_t), "Texture handles need 64 bit pointers");
 
-    _Texture *texture = (_Texture *)handle;
-    vmaDestroyImage(renderer.allocator, texture->image, texture->allocation);
-    vkDestroyImageView(renderer.device, texture->view, nullptr);
-    vkDestroySampler(renderer.device, texture->sampler, nullptr);
-
-    if (texture->framebuffer != VK_NULL_HANDLE)
-        vkDestroyFramebuffer(renderer.device, texture->framebuffer, nullptr);
+    return (Texture *)(((uint64_t)generation << 32) | (uint64_t)(index + 1));
 }
 
-void _CreateTexture(_Texture *texture, uint32_t width, uint32_t height, VkFormat format, uint8_t *pixels, VkImageUsageFlags usage)
+_Texture *AllocateTexture(Texture **handle)
 {
-    uint32_t formatMultiplier = format == VK_FORMAT_R8G8B8A8_SRGB ? 4 : 3;
+    TexturePool &pool = renderer.texturePool;
 
-    Buffer stagingBuffer = {};
-    if (pixels != nullptr)
+    uint32_t index;
+    if (!pool.freeList.empty())
     {
-        CreateBuffer(&stagingBuffer, width * height * formatMultiplier, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VMA_MEMORY_USAGE_CPU_ONLY);
+        index = pool.freeList.back();
+        pool.freeList.pop_back();
+    }
+    else
+    {
+        index = (uint32_t)pool.textures.size();
 
-        void *mem = MapBufferMemory(&stagingBuffer);
-        memcpy(mem, pixels, width * height * formatMultiplier);
-        UnmapBufferMemory(&stagingBuffer);
+        pool.generations.push_back(0);
+        pool.hot.push_back({});
+        pool.lastUsedFrames.push_back(UINT64_MAX);
+        pool.textures.push_back({});
+    }
+
+    pool.hot[index] = {};
+    pool.lastUsedFrames[index] = renderer.frameCounter;
+    pool.textures[index] = {};
+    pool.textures[index].index = index;
+    pool.textures[index].refCount = 1;
+
+    *handle = MakeTextureHandle(index, pool.generations[index]);
+
+    return &pool.textures[index];
+}
+
+void FreeTexture(_Texture *texture)
+{
+    TexturePool &pool = renderer.texturePool;
+
+    uint32_t index = texture->index;
+
+    // Bumping the generation invalidates every handle still pointing at this slot
+    pool.generations[index]++;
+    pool.hot[index] = {};
+    pool.lastUsedFrames[index] = UINT64_MAX;
+    pool.textures[index] = {};
+
+    pool.freeList.push_back(index);
+}
+
+static bool ResolveTextureHandle(Texture *handle, uint32_t *index)
+{
+    uint64_t value = (uint64_t)handle;
+    *index = (uint32_t)(value & 0xFFFFFFFF) - 1;
+    uint32_t generation = (uint32_t)(value >> 32);
+
+    return *index < renderer.texturePool.generations.size() && renderer.texturePool.generations[*index] == generation;
+}
+
+_Texture *GetTexture(Texture *handle)
+{
+    uint32_t index;
+    if (!ResolveTextureHandle(handle, &index))
+    {
+        assert(0 && "Stale or invalid texture handle");
+        return nullptr;
     }
 
+    return &renderer.texturePool.textures[index];
+}
+
+bool IsTextureValid(Texture *handle)
+{
+    uint32_t index;
+    return ResolveTextureHandle(handle, &index);
+}
+
+void DestroyTexture(Texture *handle)
+{
+    assert(handle != renderer.currentTarget && "Cannot destroy the current render target");
+
+    _Texture *texture = GetTexture(handle);
+    if (!texture)
+        return;
+
+    if (--texture->refCount > 0)
+        return;
+
+    UncacheTexture(texture);
+
+    TextureHot hot = GetTextureHot(texture);
+    _Texture cold = *texture;
+
+    if (cold.resident)
+        renderer.residentTextureBytes -= cold.residentBytes;
+
+    FreeTexture(texture);
+
+    // Draws recorded this frame may still reference the image, so it is released once the frame retires
+    AcquireCurrentFrame().deletionQueue.push_back([=]()
+    {
+        if (cold.resident)
+        {
+            vmaDestroyImage(renderer.allocator, hot.image, cold.allocation);
+            vkDestroyImageView(renderer.device, hot.view, nullptr);
+            if (cold.targetView != hot.view)
+                vkDestroyImageView(renderer.device, cold.targetView, nullptr);
+        }
+
+        vkFreeDescriptorSets(renderer.device, renderer.descriptorPool, 1, &hot.set);
+        vkDestroySampler(renderer.device, cold.sampler, nullptr);
+
+        if (cold.framebuffer != VK_NULL_HANDLE)
+            vkDestroyFramebuffer(renderer.device, cold.framebuffer, nullptr);
+
+        free(cold.evictedPixels);
+    });
+}
+
+void _CreateTextureImage(_Texture *texture)
+{
+    TextureHot &hot = GetTextureHot(texture);
+
     VkImageCreateInfo imageInfo = {};
     imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
     imageInfo.pNext = nullptr;
     imageInfo.flags = 0;
     imageInfo.imageType = VK_IMAGE_TYPE_2D;
-    imageInfo.format = format;
-    imageInfo.extent = { width, height, 1 };
+    imageInfo.format = texture->format;
+    imageInfo.extent = { texture->width, texture->height, 1 };
     imageInfo.mipLevels = 1;
     imageInfo.arrayLayers = 1;
     imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
     imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
-    imageInfo.usage = usage;
+    imageInfo.usage = texture->usage;
     imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
     imageInfo.queueFamilyIndexCount = 0;
     imageInfo.pQueueFamilyIndices = nullptr;
@@ -123,15 +422,21 @@ void _CreateTexture(_Texture *texture, uint32_t width, uint32_t height, VkFormat
     VmaAllocationCreateInfo allocInfo = {};
     allocInfo.usage = VMA_MEMORY_USAGE_GPU_ONLY;
 
-    VkCheck(vmaCreateImage(renderer.allocator, &imageInfo, &allocInfo, &texture->image, &texture->allocation, nullptr));
+    VkResult result = vmaCreateImage(renderer.allocator, &imageInfo, &allocInfo, &hot.image, &texture->allocation, nullptr);
+
+    // Make room by evicting textures that have not been drawn recently, then try once more
+    if (result == VK_ERROR_OUT_OF_DEVICE_MEMORY && EvictTextures(GetFormatTexelSize(texture->format) * texture->width * texture->height))
+        result = vmaCreateImage(renderer.allocator, &imageInfo, &allocInfo, &hot.image, &texture->allocation, nullptr);
+
+    VkCheck(result);
 
     VkImageViewCreateInfo viewInfo = {};
     viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
     viewInfo.pNext = nullptr;
     viewInfo.flags = 0;
-    viewInfo.image = texture->image;
+    viewInfo.image = hot.image;
     viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
-    viewInfo.format = format;
+    viewInfo.format = texture->format;
     viewInfo.components = { VK_COMPONENT_SWIZZLE_R, VK_COMPONENT_SWIZZLE_G, VK_COMPONENT_SWIZZLE_B, VK_COMPONENT_SWIZZLE_A };
     viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
     viewInfo.subresourceRange.baseMipLevel = 0;
@@ -139,7 +444,105 @@ void _CreateTexture(_Texture *texture, uint32_t width, uint32_t height, VkFormat
     viewInfo.subresourceRange.baseArrayLayer = 0;
     viewInfo.subresourceRange.levelCount = 1;
 
-    VkCheck(vkCreateImageView(renderer.device, &viewInfo, nullptr, &texture->view));
+    // Framebuffer attachments require an identity swizzle, so it gets its own view
+    texture->targetView = VK_NULL_HANDLE;
+    if (texture->usage & VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT)
+        VkCheck(vkCreateImageView(renderer.device, &viewInfo, nullptr, &texture->targetView));
+
+    // Single and dual channel formats sample as coverage so they can be tinted like any other texture
+    bool swizzled = true;
+    if (texture->format == VK_FORMAT_R8_UNORM)
+        viewInfo.components = { VK_COMPONENT_SWIZZLE_ONE, VK_COMPONENT_SWIZZLE_ONE, VK_COMPONENT_SWIZZLE_ONE, VK_COMPONENT_SWIZZLE_R };
+    else if (texture->format == VK_FORMAT_R8G8_UNORM)
+        viewInfo.components = { VK_COMPONENT_SWIZZLE_R, VK_COMPONENT_SWIZZLE_R, VK_COMPONENT_SWIZZLE_R, VK_COMPONENT_SWIZZLE_G };
+    else
+        swizzled = false;
+
+    if (texture->targetView != VK_NULL_HANDLE && !swizzled)
+        hot.view = texture->targetView;
+    else
+        VkCheck(vkCreateImageView(renderer.device, &viewInfo, nullptr, &hot.view));
+
+    VmaAllocationInfo allocationInfo = {};
+    vmaGetAllocationInfo(renderer.allocator, texture->allocation, &allocationInfo);
+
+    texture->resident = true;
+    texture->residentBytes = allocationInfo.size;
+    renderer.residentTextureBytes += texture->residentBytes;
+}
+
+void _DestroyTextureImage(_Texture *texture)
+{
+    TextureHot &hot = GetTextureHot(texture);
+
+    vmaDestroyImage(renderer.allocator, hot.image, texture->allocation);
+    vkDestroyImageView(renderer.device, hot.view, nullptr);
+    if (texture->targetView != hot.view)
+        vkDestroyImageView(renderer.device, texture->targetView, nullptr);
+
+    hot.image = VK_NULL_HANDLE;
+    hot.view = VK_NULL_HANDLE;
+    texture->targetView = VK_NULL_HANDLE;
+
+    texture->resident = false;
+    renderer.residentTextureBytes -= texture->residentBytes;
+    texture->residentBytes = 0;
+}
+
+void _WriteTextureDescriptor(_Texture *texture)
+{
+    TextureHot &hot = GetTextureHot(texture);
+
+    VkDescriptorImageInfo setImageInfo = {};
+    setImageInfo.sampler = texture->sampler;
+    setImageInfo.imageView = hot.view;
+    setImageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+
+    VkWriteDescriptorSet write = {};
+    write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    write.pNext = nullptr;
+    write.dstSet = hot.set;
+    write.dstBinding = 0;
+    write.dstArrayElement = 0;
+    write.descriptorCount = 1;
+    write.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    write.pImageInfo = &setImageInfo;
+    write.pBufferInfo = nullptr;
+    write.pTexelBufferView = nullptr;
+
+    vkUpdateDescriptorSets(renderer.device, 1, &write, 0, nullptr);
+}
+
+glm::vec2 TextureGetExtent(Texture *handle)
+{
+    _Texture *texture = GetTexture(handle);
+
+    return glm::vec2((float)texture->width, (float)texture->height);
+}
+
+void _CreateTexture(_Texture *texture, uint32_t width, uint32_t height, VkFormat format, const uint8_t *pixels, VkImageUsageFlags usage, uint32_t conversion /* = 0 */)
+{
+    texture->width = width;
+    texture->height = height;
+    texture->format = format;
+
+    // Transfer source so the residency manager can read the image back when evicting it
+    texture->usage = usage | VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+
+    uint32_t texelSize = GetFormatTexelSize(format);
+
+    Buffer stagingBuffer = {};
+    if (pixels != nullptr)
+    {
+        CreateBuffer(&stagingBuffer, width * height * texelSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VMA_MEMORY_USAGE_CPU_ONLY);
+
+        // Converted straight into the mapping, the decoded image is never copied twice
+        uint8_t *mem = (uint8_t *)MapBufferMemory(&stagingBuffer);
+        ConvertPixels(mem, pixels, width, height, texelSize, conversion);
+        UnmapBufferMemory(&stagingBuffer);
+    }
+
+    _CreateTextureImage(texture);
 
     VkPhysicalDeviceProperties properties = {};
     vkGetPhysicalDeviceProperties(renderer.physicalDevice, &properties);
@@ -183,9 +586,9 @@ void _CreateTexture(_Texture *texture, uint32_t width, uint32_t height, VkFormat
         region.imageSubresource.mipLevel = 0;
 
         region.imageOffset = { 0, 0, 0 };
-        region.imageExtent = { width, height, 1 };
+        region.imageExtent = { texture->width, texture->height, 1 };
 
-        vkCmdCopyBufferToImage(cmdBuffer, stagingBuffer.buffer, texture->image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+        vkCmdCopyBufferToImage(cmdBuffer, stagingBuffer.buffer, GetTextureHot(texture).image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
 
         EndSingleUseCommand(cmdBuffer);
 
@@ -198,31 +601,92 @@ void _CreateTexture(_Texture *texture, uint32_t width, uint32_t height, VkFormat
         TransitionImageLayout(texture, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
     }
 
-    texture->set = std::move(AllocateDescriptorSets(&renderer.texturePipeline, 1, 1)[0]);
+    GetTextureHot(texture).set = std::move(AllocateDescriptorSets(&renderer.texturePipeline, 1, 1)[0]);
 
-    VkDescriptorImageInfo setImageInfo = {};
-    setImageInfo.sampler = texture->sampler;
-    setImageInfo.imageView = texture->view;
-    setImageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    _WriteTextureDescriptor(texture);
 
-    VkWriteDescriptorSet write = {};
-    write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-    write.pNext = nullptr;
-    write.dstSet = texture->set;
-    write.dstBinding = 0;
-    write.dstArrayElement = 0;
-    write.descriptorCount = 1;
-    write.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-    write.pImageInfo = &setImageInfo;
-    write.pBufferInfo = nullptr;
-    write.pTexelBufferView = nullptr;
+    renderer.texturePool.lastUsedFrames[texture->index] = renderer.frameCounter;
+}
 
-    vkUpdateDescriptorSets(renderer.device, 1, &write, 0, nullptr);
+uint32_t GetFormatTexelSize(VkFormat format)
+{
+    switch (format)
+    {
+        case VK_FORMAT_R8_UNORM: return 1;
+        case VK_FORMAT_R8G8_UNORM: return 2;
+        case VK_FORMAT_R8G8B8A8_SRGB: return 4;
+        case VK_FORMAT_R8G8B8A8_UNORM: return 4;
+        case VK_FORMAT_B8G8R8A8_SRGB: return 4;
+        case VK_FORMAT_B8G8R8A8_UNORM: return 4;
+        case VK_FORMAT_R16G16B16A16_SFLOAT: return 8;
+        default:
+        {
+            assert(0 && "Unknown texture format");
+            return 0;
+        }
+    }
 }
 
-glm::vec2 TextureGetExtent(Texture *handle)
+void UpdateTextureRegion(Texture *handle, uint32_t x, uint32_t y, uint32_t width, uint32_t height, const uint8_t *pixels, uint32_t stride /* = 0 */)
 {
-    _Texture *texture = (_Texture *)handle;
+    _Texture *texture = GetTexture(handle);
 
-    return glm::vec2((float)texture->width, (float)texture->height);
+    assert(handle != renderer.currentTarget && "Cannot update a texture that is currently being rendered to");
+    assert(x <= texture->width && width <= texture->width - x && y <= texture->height && height <= texture->height - y);
+
+    // Every load of the same file or deduplicated pixels holds this handle, they would all see the change
+    if (texture->refCount > 1)
+    {
+        printf("Cannot update a texture shared by %u loads, load it without deduplication to modify it\n", texture->refCount);
+        return;
+    }
+
+    MakeTextureResident(texture);
+    UncacheTexture(texture);
+
+    // The contents now differ from any immutable backing data, so evictions need a real readback
+    texture->sourcePixels = nullptr;
+    renderer.texturePool.lastUsedFrames[texture->index] = renderer.frameCounter;
+
+    VkImage image = GetTextureHot(texture).image;
+
+    uint32_t texelSize = GetFormatTexelSize(texture->format);
+    uint32_t rowSize = width * texelSize;
+    if (stride == 0)
+        stride = rowSize;
+
+    StagingAllocation staging = AllocateStaging(rowSize * height, 16);
+
+    if (stride == rowSize)
+    {
+        memcpy(staging.mapped, pixels, rowSize * height);
+    }
+    else
+    {
+        for (uint32_t row = 0; row < height; ++row)
+        {
+            memcpy(staging.mapped + row * rowSize, pixels + row * stride, rowSize);
+        }
+    }
+
+    VkCommandBuffer cmdBuffer = GetUploadCommandBuffer();
+
+    RecordImageBarrier(cmdBuffer, image, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+
+    VkBufferImageCopy region = {};
+    region.bufferOffset = staging.offset;
+    region.bufferRowLength = 0;
+    region.bufferImageHeight = 0;
+
+    region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    region.imageSubresource.layerCount = 1;
+    region.imageSubresource.baseArrayLayer = 0;
+    region.imageSubresource.mipLevel = 0;
+
+    region.imageOffset = { (int32_t)x, (int32_t)y, 0 };
+    region.imageExtent = { width, height, 1 };
+
+    vkCmdCopyBufferToImage(cmdBuffer, staging.buffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+
+    RecordImageBarrier(cmdBuffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
 }
\ No newline at end of file
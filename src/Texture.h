@@ -5,19 +5,91 @@
 
 #include <glm/glm.hpp>
 
-struct _Texture
+#include <string>
+#include <vector>
+
+#include "Renderer.h"
+
+// Read by every draw, kept apart from the rest of the texture state
+struct TextureHot
 {
     VkImage image;
+    VkImageView view;
+    VkDescriptorSet set;
+};
+
+// Cold metadata, touched on creation, updates, residency changes and render target switches
+struct _Texture
+{
+    uint32_t index;
+
     VmaAllocation allocation;
 
-    VkImageView view;
+    VkImageView targetView;
     VkSampler sampler;
     VkFramebuffer framebuffer;
 
-    VkDescriptorSet set;
-
     uint32_t width, height;
     VkFormat format;
+    VkImageUsageFlags usage;
+
+    // Residency, the image and views only exist while resident
+    bool resident;
+    uint64_t residentBytes;
+
+    uint8_t *evictedPixels;         // CPU copy of the contents while evicted
+    const uint8_t *sourcePixels;    // Immutable backing data (an asset pack mapping or cached pixels), lets eviction skip the readback
+
+    // Deduplicated textures are shared, DestroyTexture only releases the image once every load is matched
+    uint32_t refCount;
+    bool cached;
+    uint64_t cacheKey;
+};
+
+// The full key of a shared texture, compared on lookup since the cache is keyed by its hash. Textures
+// loaded from pixels have no path and keep a copy of their contents, which also backs them while evicted.
+struct TextureCacheEntry
+{
+    Texture *texture;
+
+    std::string path;
+    TextureFormat format;
+    uint32_t flags;
+
+    // Deduplicated pixels are matched by a second, independently seeded hash rather than a copy of the
+    // pixels, which would otherwise stay in memory for as long as the texture lives
+    uint32_t width, height;
+    uint64_t contentHash;
 };
 
-void _CreateTexture(_Texture *texture, uint32_t width, uint32_t height, VkFormat format, uint8_t *pixels, VkImageUsageFlags usage);
\ No newline at end of file
+// Textures live in one contiguous pool split into parallel arrays. The Texture * handed out to
+// users is not a pointer but (generation << 32) | (index + 1), so a stale handle fails a single
+// compare against generations[index] and a null handle never resolves.
+struct TexturePool
+{
+    std::vector<uint32_t> generations;
+    std::vector<TextureHot> hot;
+    std::vector<uint64_t> lastUsedFrames;   // UINT64_MAX for free slots
+    std::vector<_Texture> textures;
+
+    std::vector<uint32_t> freeList;
+};
+
+// Pointers returned here are invalidated by the next AllocateTexture
+_Texture *AllocateTexture(Texture **handle);
+void FreeTexture(_Texture *texture);
+_Texture *GetTexture(Texture *handle);
+
+VkFormat GetTextureVkFormat(TextureFormat format);
+uint32_t GetFormatTexelSize(VkFormat format);
+
+// conversion takes PixelConversionFlags, applied while the pixels are written to staging memory
+void _CreateTexture(_Texture *texture, uint32_t width, uint32_t height, VkFormat format, const uint8_t *pixels, VkImageUsageFlags usage, uint32_t conversion = 0);
+
+void _CreateTextureImage(_Texture *texture);
+void _DestroyTextureImage(_Texture *texture);
+void _WriteTextureDescriptor(_Texture *texture);
+
+void MakeTextureResident(_Texture *texture);
+bool EvictTextures(uint64_t bytes);
+void UpdateTextureResidency();
\ No newline at end of file
@@ -0,0 +1,178 @@
+#include "Texture.h"
+
+#include "Internal.h"
+#include "Utils.h"
+
+#include <algorithm>
+
+// Textures are only evicted once the last frame that used them has retired, which needs the current
+// frame's fence to have been waited on, see EvictTextures
+static bool IsEvictable(uint32_t index)
+{
+    // Free slots hold UINT64_MAX and fail the age test without touching the cold data
+    uint64_t lastUsedFrame = renderer.texturePool.lastUsedFrames[index];
+    if (lastUsedFrame == UINT64_MAX || lastUsedFrame + renderer.frames.size() > renderer.frameCounter)
+        return false;
+
+    _Texture &texture = renderer.texturePool.textures[index];
+
+    // Render target contents are produced on the GPU every frame, they are never evicted
+    return texture.resident && (texture.usage & VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT) == 0;
+}
+
+static uint64_t EvictTexture(_Texture *texture)
+{
+    uint64_t freed = texture->residentBytes;
+
+    VkImage image = GetTextureHot(texture).image;
+
+    if (!texture->sourcePixels)
+    {
+        uint32_t size = texture->width * texture->height * GetFormatTexelSize(texture->format);
+
+        Buffer readback = {};
+        CreateBuffer(&readback, size, VK_BUFFER_USAGE_TRANSFER_DST_BIT, VMA_MEMORY_USAGE_GPU_TO_CPU);
+
+        VkCommandBuffer cmdBuffer = BeginSingleUseCommand();
+
+        RecordImageBarrier(cmdBuffer, image, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL);
+
+        VkBufferImageCopy region = {};
+        region.bufferOffset = 0;
+        region.bufferRowLength = 0;
+        region.bufferImageHeight = 0;
+
+        region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        region.imageSubresource.layerCount = 1;
+        region.imageSubresource.baseArrayLayer = 0;
+        region.imageSubresource.mipLevel = 0;
+
+        region.imageOffset = { 0, 0, 0 };
+        region.imageExtent = { texture->width, texture->height, 1 };
+
+        vkCmdCopyImageToBuffer(cmdBuffer, image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, readback.buffer, 1, &region);
+
+        EndSingleUseCommand(cmdBuffer);
+
+        texture->evictedPixels = (uint8_t *)malloc(size);
+
+        void *mem = MapBufferMemory(&readback);
+        memcpy(texture->evictedPixels, mem, size);
+        UnmapBufferMemory(&readback);
+
+        DestroyBuffer(&readback);
+    }
+
+    // The descriptor set keeps pointing at the destroyed view, it is rewritten before the texture is bound again
+    _DestroyTextureImage(texture);
+
+    return freed;
+}
+
+bool EvictTextures(uint64_t bytes)
+{
+    ZoneScopedN("EvictTextures");
+
+    // frameCounter moves on in RendererEndFrame, but the frame that last used this slot is only waited on
+    // here. Until then the age test would pass for textures that may still be in use on the GPU.
+    AcquireCurrentFrame();
+
+    TexturePool &pool = renderer.texturePool;
+
+    std::vector<uint32_t> candidates;
+    for (uint32_t i = 0; i < pool.lastUsedFrames.size(); ++i)
+    {
+        if (IsEvictable(i))
+            candidates.push_back(i);
+    }
+
+    std::sort(candidates.begin(), candidates.end(), [&](uint32_t a, uint32_t b)
+    {
+        return pool.lastUsedFrames[a] < pool.lastUsedFrames[b];
+    });
+
+    uint64_t freed = 0;
+    for (uint32_t i = 0; i < candidates.size() && freed < bytes; ++i)
+    {
+        freed += EvictTexture(&pool.textures[candidates[i]]);
+    }
+
+    return freed > 0;
+}
+
+void MakeTextureResident(_Texture *texture)
+{
+    if (texture->resident)
+        return;
+
+    ZoneScopedN("MakeTextureResident");
+
+    _CreateTextureImage(texture);
+
+    VkImage image = GetTextureHot(texture).image;
+
+    const uint8_t *pixels = texture->sourcePixels ? texture->sourcePixels : texture->evictedPixels;
+    uint32_t size = texture->width * texture->height * GetFormatTexelSize(texture->format);
+
+    StagingAllocation staging = AllocateStaging(size, 16);
+    memcpy(staging.mapped, pixels, size);
+
+    VkCommandBuffer cmdBuffer = GetUploadCommandBuffer();
+
+    RecordImageBarrier(cmdBuffer, image, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+
+    VkBufferImageCopy region = {};
+    region.bufferOffset = staging.offset;
+    region.bufferRowLength = 0;
+    region.bufferImageHeight = 0;
+
+    region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    region.imageSubresource.layerCount = 1;
+    region.imageSubresource.baseArrayLayer = 0;
+    region.imageSubresource.mipLevel = 0;
+
+    region.imageOffset = { 0, 0, 0 };
+    region.imageExtent = { texture->width, texture->height, 1 };
+
+    vkCmdCopyBufferToImage(cmdBuffer, staging.buffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+
+    RecordImageBarrier(cmdBuffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+
+    _WriteTextureDescriptor(texture);
+
+    free(texture->evictedPixels);
+    texture->evictedPixels = nullptr;
+}
+
+void UpdateTextureResidency()
+{
+    uint64_t overBudget = 0;
+
+    if (renderer.textureBudget != 0 && renderer.residentTextureBytes > renderer.textureBudget)
+        overBudget = renderer.residentTextureBytes - renderer.textureBudget;
+
+    const VkPhysicalDeviceMemoryProperties *memoryProperties = nullptr;
+    vmaGetMemoryProperties(renderer.allocator, &memoryProperties);
+
+    VmaBudget budgets[VK_MAX_MEMORY_HEAPS] = {};
+    vmaGetBudget(renderer.allocator, budgets);
+
+    for (uint32_t i = 0; i < memoryProperties->memoryHeapCount; ++i)
+    {
+        if ((memoryProperties->memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) == 0)
+            continue;
+
+        // Keep some headroom below the budget for swapchain and driver allocations
+        uint64_t limit = budgets[i].budget / 10 * 9;
+        if (budgets[i].usage > limit)
+            overBudget = std::max(overBudget, budgets[i].usage - limit);
+    }
+
+    if (overBudget > 0)
+        EvictTextures(overBudget);
+}
+
+void SetTextureMemoryBudget(uint64_t bytes)
+{
+    renderer.textureBudget = bytes;
+}
\ No newline at end of file
@@ -0,0 +1,168 @@
+#include "TrueType.h"
+
+bool ParseTrueType(TrueTypeFont *font, const uint8_t *data, uint32_t size)
+{
+    // stb_truetype reads the table directory without knowing the size, so a truncated header is caught here
+    if (size < 12)
+        return false;
+
+    int offset = stbtt_GetFontOffsetForIndex(data, 0);
+    if (offset < 0 || (uint32_t)offset >= size || !stbtt_InitFont(&font->info, data, offset))
+        return false;
+
+    // The scale for one pixel per em is one over the units per em
+    float unitScale = stbtt_ScaleForMappingEmToPixels(&font->info, 1.0f);
+    if (!(unitScale > 0.0f) || unitScale > 1.0f)
+        return false;
+
+    font->unitsPerEm = (int32_t)(1.0f / unitScale + 0.5f);
+
+    int ascender, descender, lineGap;
+    stbtt_GetFontVMetrics(&font->info, &ascender, &descender, &lineGap);
+
+    font->ascender = ascender;
+    font->descender = descender;
+    font->lineGap = lineGap;
+
+    return true;
+}
+
+uint32_t FindGlyph(const TrueTypeFont *font, uint32_t codepoint)
+{
+    return (uint32_t)stbtt_FindGlyphIndex(&font->info, (int)codepoint);
+}
+
+void GetGlyphMetrics(const TrueTypeFont *font, uint32_t glyph, int32_t *advance, int32_t *leftBearing)
+{
+    int glyphAdvance, glyphBearing;
+    stbtt_GetGlyphHMetrics(&font->info, (int)glyph, &glyphAdvance, &glyphBearing);
+
+    *advance = glyphAdvance;
+    *leftBearing = glyphBearing;
+}
+
+int32_t GetKerning(const TrueTypeFont *font, uint32_t left, uint32_t right)
+{
+    return stbtt_GetGlyphKernAdvance(&font->info, (int)left, (int)right);
+}
+
+bool IsGlyphEmpty(const TrueTypeFont *font, uint32_t glyph)
+{
+    return stbtt_IsGlyphEmpty(&font->info, (int)glyph) != 0;
+}
+
+static void AddEdge(GlyphOutline *outline, glm::vec2 p0, glm::vec2 control, glm::vec2 p1, bool curved)
+{
+    OutlineEdge edge;
+    edge.p0 = p0;
+    edge.control = curved ? control : (p0 + p1) * 0.5f;
+    edge.p1 = p1;
+    edge.curved = curved;
+
+    outline->edges.push_back(edge);
+}
+
+// Each half of the cubic becomes the quadratic that matches its end tangents on average, which is well
+// within a texel at atlas sizes
+static void AddCubic(GlyphOutline *outline, glm::vec2 p0, glm::vec2 c0, glm::vec2 c1, glm::vec2 p1)
+{
+    glm::vec2 a = (p0 + c0) * 0.5f;
+    glm::vec2 b = (c0 + c1) * 0.5f;
+    glm::vec2 c = (c1 + p1) * 0.5f;
+    glm::vec2 ab = (a + b) * 0.5f;
+    glm::vec2 bc = (b + c) * 0.5f;
+    glm::vec2 middle = (ab + bc) * 0.5f;
+
+    AddEdge(outline, p0, (3.0f * (a + ab) - p0 - middle) * 0.25f, middle, true);
+    AddEdge(outline, middle, (3.0f * (bc + c) - middle - p1) * 0.25f, p1, true);
+}
+
+// Ends the current contour, with a line back to its start if the font left it open
+static void CloseContour(GlyphOutline *outline, glm::vec2 current, glm::vec2 start)
+{
+    uint32_t first = outline->contourEnds.empty() ? 0 : outline->contourEnds.back();
+    if (outline->edges.size() == first)
+        return;
+
+    if (current != start)
+        AddEdge(outline, current, current, start, false);
+
+    outline->contourEnds.push_back((uint32_t)outline->edges.size());
+}
+
+bool GetGlyphOutline(const TrueTypeFont *font, uint32_t glyph, GlyphOutline *outline)
+{
+    outline->edges.clear();
+    outline->contourEnds.clear();
+
+    stbtt_vertex *vertices = nullptr;
+    int count = stbtt_GetGlyphShape(&font->info, (int)glyph, &vertices);
+
+    glm::vec2 start = {};
+    glm::vec2 current = {};
+
+    for (int i = 0; i < count; ++i)
+    {
+        const stbtt_vertex &vertex = vertices[i];
+        glm::vec2 point = { vertex.x, vertex.y };
+
+        switch (vertex.type)
+        {
+            case STBTT_vmove:
+                CloseContour(outline, current, start);
+                start = point;
+                break;
+
+            case STBTT_vline:
+                if (point != current)
+                    AddEdge(outline, current, current, point, false);
+                break;
+
+            case STBTT_vcurve:
+                AddEdge(outline, current, { vertex.cx, vertex.cy }, point, true);
+                break;
+
+            case STBTT_vcubic:
+                AddCubic(outline, current, { vertex.cx, vertex.cy }, { vertex.cx1, vertex.cy1 }, point);
+                break;
+        }
+
+        current = point;
+    }
+
+    CloseContour(outline, current, start);
+
+    stbtt_FreeShape(&font->info, vertices);
+
+    if (outline->edges.empty())
+        return false;
+
+    // From the edges rather than the glyph header, which composites with transforms don't keep accurate.
+    // Control points bound their curve, so this may be slightly larger than the ink.
+    outline->min = outline->edges[0].p0;
+    outline->max = outline->edges[0].p0;
+
+    for (const OutlineEdge &edge : outline->edges)
+    {
+        outline->min = glm::min(outline->min, glm::min(edge.p0, glm::min(edge.control, edge.p1)));
+        outline->max = glm::max(outline->max, glm::max(edge.p0, glm::max(edge.control, edge.p1)));
+    }
+
+    return true;
+}
+
+void GetGlyphBitmapBox(const TrueTypeFont *font, uint32_t glyph, float scale, int32_t *left, int32_t *top, int32_t *right, int32_t *bottom)
+{
+    int x0, y0, x1, y1;
+    stbtt_GetGlyphBitmapBox(&font->info, (int)glyph, scale, scale, &x0, &y0, &x1, &y1);
+
+    *left = x0;
+    *top = y0;
+    *right = x1;
+    *bottom = y1;
+}
+
+void RasterizeGlyph(const TrueTypeFont *font, uint32_t glyph, float scale, uint8_t *pixels, uint32_t width, uint32_t height, uint32_t stride)
+{
+    stbtt_MakeGlyphBitmap(&font->info, pixels, (int)width, (int)height, (int)stride, scale, scale, (int)glyph);
+}
\ No newline at end of file
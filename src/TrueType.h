@@ -0,0 +1,66 @@
+#pragma once
+
+#include <stdint.h>
+
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include <stb_truetype.h>
+
+// Fonts are read by stb_truetype straight from the file data, which must outlive the font. It handles
+// TrueType and CFF outlines and kern or GPOS kerning, but only does light validation of the tables, so
+// fonts should come from the application's own assets.
+struct TrueTypeFont
+{
+    stbtt_fontinfo info;
+
+    int32_t unitsPerEm;
+    int32_t ascender;
+    int32_t descender;          // Negative, below the baseline
+    int32_t lineGap;
+};
+
+// Lines have their control point in the middle, so every edge can be evaluated as a quadratic
+struct OutlineEdge
+{
+    glm::vec2 p0;
+    glm::vec2 control;
+    glm::vec2 p1;
+
+    bool curved;
+};
+
+// In font units with y up. Contours are closed, the edges of each one run in order.
+struct GlyphOutline
+{
+    std::vector<OutlineEdge> edges;
+    std::vector<uint32_t> contourEnds;      // One past the last edge of each contour
+
+    glm::vec2 min;
+    glm::vec2 max;
+};
+
+// Uses the first font of collections
+bool ParseTrueType(TrueTypeFont *font, const uint8_t *data, uint32_t size);
+
+// 0 is the missing glyph
+uint32_t FindGlyph(const TrueTypeFont *font, uint32_t codepoint);
+
+// In font units
+void GetGlyphMetrics(const TrueTypeFont *font, uint32_t glyph, int32_t *advance, int32_t *leftBearing);
+int32_t GetKerning(const TrueTypeFont *font, uint32_t left, uint32_t right);
+
+// Glyphs without contours, like spaces
+bool IsGlyphEmpty(const TrueTypeFont *font, uint32_t glyph);
+
+// Cubic curves of CFF outlines are split into quadratics. Returns false for empty glyphs.
+bool GetGlyphOutline(const TrueTypeFont *font, uint32_t glyph, GlyphOutline *outline);
+
+// Pixel bounds of the glyph's bitmap at scale pixels per font unit, with y down and relative to the pen
+// position on the baseline. Empty for glyphs without contours.
+void GetGlyphBitmapBox(const TrueTypeFont *font, uint32_t glyph, float scale, int32_t *left, int32_t *top, int32_t *right, int32_t *bottom);
+
+// Writes the glyph's coverage into a width by height 8 bit bitmap placed at the GetGlyphBitmapBox
+// origin, the first row is the top of the glyph
+void RasterizeGlyph(const TrueTypeFont *font, uint32_t glyph, float scale, uint8_t *pixels, uint32_t width, uint32_t height, uint32_t stride);
\ No newline at end of file
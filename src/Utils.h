@@ -6,6 +6,7 @@
 #include <vector>
 
 #include "Renderer.h"
+#include "Hash.h"
 
 inline const char *GetVkResultString(VkResult result)
 {
@@ -175,17 +176,15 @@ inline void EndSingleUseCommand(VkCommandBuffer cmdBuffer)
     vkFreeCommandBuffers(renderer.device, renderer.commandPool, 1, &cmdBuffer);
 }
 
-inline void TransitionImageLayout(_Texture *texture, VkImageLayout oldLayout, VkImageLayout newLayout)
+inline void RecordImageBarrier(VkCommandBuffer cmdBuffer, VkImage image, VkImageLayout oldLayout, VkImageLayout newLayout)
 {
-    VkCommandBuffer cmdBuffer = BeginSingleUseCommand();
-
     VkImageMemoryBarrier barrier = {};
     barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
     barrier.oldLayout = oldLayout;
     barrier.newLayout = newLayout;
     barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
     barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-    barrier.image = texture->image;
+    barrier.image = image;
     barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
     barrier.subresourceRange.baseMipLevel = 0;
     barrier.subresourceRange.levelCount = 1;
@@ -211,6 +210,23 @@ inline void TransitionImageLayout(_Texture *texture, VkImageLayout oldLayout, Vk
             sourceStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
             destStage = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
     }
+    else if (oldLayout == VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL && newLayout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL)
+    {
+        // Earlier frames may still be sampling the image
+        barrier.srcAccessMask = VK_ACCESS_SHADER_READ_BIT;
+        barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+
+        sourceStage = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+        destStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
+    }
+    else if (oldLayout == VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL && newLayout == VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL)
+    {
+        barrier.srcAccessMask = VK_ACCESS_SHADER_READ_BIT;
+        barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+
+        sourceStage = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+        destStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
+    }
     else if (oldLayout == VK_IMAGE_LAYOUT_UNDEFINED && newLayout == VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL)
     {
         barrier.srcAccessMask = 0;
@@ -221,6 +237,13 @@ inline void TransitionImageLayout(_Texture *texture, VkImageLayout oldLayout, Vk
     }
 
     vkCmdPipelineBarrier(cmdBuffer, sourceStage, destStage, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+}
+
+inline void TransitionImageLayout(_Texture *texture, VkImageLayout oldLayout, VkImageLayout newLayout)
+{
+    VkCommandBuffer cmdBuffer = BeginSingleUseCommand();
+
+    RecordImageBarrier(cmdBuffer, GetTextureHot(texture).image, oldLayout, newLayout);
 
     EndSingleUseCommand(cmdBuffer);
 }
\ No newline at end of file
@@ -0,0 +1,131 @@
+#include "Internal.h"
+
+#include "Utils.h"
+
+#include <Windows.h>
+
+bool PlatformMapFile(MappedFile *file, const char *path)
+{
+    file->win32.file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file->win32.file == INVALID_HANDLE_VALUE)
+        return false;
+
+    LARGE_INTEGER size = {};
+    if (!GetFileSizeEx(file->win32.file, &size) || size.QuadPart == 0)
+    {
+        CloseHandle(file->win32.file);
+        return false;
+    }
+
+    file->win32.mapping = CreateFileMappingA(file->win32.file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (file->win32.mapping == nullptr)
+    {
+        CloseHandle(file->win32.file);
+        return false;
+    }
+
+    file->data = (const uint8_t *)MapViewOfFile(file->win32.mapping, FILE_MAP_READ, 0, 0, 0);
+    if (file->data == nullptr)
+    {
+        CloseHandle(file->win32.mapping);
+        CloseHandle(file->win32.file);
+        return false;
+    }
+
+    file->size = (size_t)size.QuadPart;
+
+    return true;
+}
+
+void PlatformUnmapFile(MappedFile *file)
+{
+    UnmapViewOfFile(file->data);
+    CloseHandle(file->win32.mapping);
+    CloseHandle(file->win32.file);
+
+    file->data = nullptr;
+    file->size = 0;
+}
+
+bool PlatformCreateDirectory(const char *path)
+{
+    return CreateDirectoryA(path, nullptr) || GetLastError() == ERROR_ALREADY_EXISTS;
+}
+
+bool PlatformReplaceFile(const char *source, const char *destination)
+{
+    return MoveFileExA(source, destination, MOVEFILE_REPLACE_EXISTING) != 0;
+}
+
+bool PlatformWatchDirectory(FileWatcher *watcher, const char *path)
+{
+    watcher->win32.directory = CreateFileA(path, FILE_LIST_DIRECTORY, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED, nullptr);
+    if (watcher->win32.directory == INVALID_HANDLE_VALUE)
+        return false;
+
+    watcher->win32.changeEvent = CreateEventA(nullptr, FALSE, FALSE, nullptr);
+    watcher->win32.cancelEvent = CreateEventA(nullptr, TRUE, FALSE, nullptr);
+
+    return true;
+}
+
+bool PlatformWaitForFileChanges(FileWatcher *watcher, std::vector<std::string> *changed)
+{
+    Win32FileWatcher &win32 = watcher->win32;
+
+    win32.overlapped = {};
+    win32.overlapped.hEvent = win32.changeEvent;
+
+    DWORD filter = FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_FILE_NAME;
+    if (!ReadDirectoryChangesW(win32.directory, win32.buffer, sizeof(win32.buffer), FALSE, filter, nullptr, &win32.overlapped, nullptr))
+        return false;
+
+    HANDLE events[2] = { win32.changeEvent, win32.cancelEvent };
+    DWORD signaled = WaitForMultipleObjects(2, events, FALSE, INFINITE);
+
+    DWORD bytes = 0;
+    if (signaled != WAIT_OBJECT_0)
+    {
+        // The buffer belongs to the pending read until it has actually been cancelled
+        CancelIoEx(win32.directory, &win32.overlapped);
+        GetOverlappedResult(win32.directory, &win32.overlapped, &bytes, TRUE);
+        return false;
+    }
+
+    if (!GetOverlappedResult(win32.directory, &win32.overlapped, &bytes, FALSE))
+        return false;
+
+    changed->clear();
+
+    // Zero bytes means the buffer overflowed, the caller treats an empty list as "anything may have changed"
+    uint8_t *record = (uint8_t *)win32.buffer;
+    while (bytes > 0)
+    {
+        FILE_NOTIFY_INFORMATION *info = (FILE_NOTIFY_INFORMATION *)record;
+
+        int length = WideCharToMultiByte(CP_UTF8, 0, info->FileName, info->FileNameLength / sizeof(WCHAR), nullptr, 0, nullptr, nullptr);
+        std::string name(length, '\0');
+        WideCharToMultiByte(CP_UTF8, 0, info->FileName, info->FileNameLength / sizeof(WCHAR), &name[0], length, nullptr, nullptr);
+
+        changed->push_back(name);
+
+        if (info->NextEntryOffset == 0)
+            break;
+
+        record += info->NextEntryOffset;
+    }
+
+    return true;
+}
+
+void PlatformCancelFileWatch(FileWatcher *watcher)
+{
+    SetEvent(watcher->win32.cancelEvent);
+}
+
+void PlatformCloseFileWatch(FileWatcher *watcher)
+{
+    CloseHandle(watcher->win32.cancelEvent);
+    CloseHandle(watcher->win32.changeEvent);
+    CloseHandle(watcher->win32.directory);
+}
\ No newline at end of file
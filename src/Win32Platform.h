@@ -1,10 +1,28 @@
 #pragma once
 
 #define PLATFORM_WINDOW Win32Window win32;
+#define PLATFORM_MAPPED_FILE Win32MappedFile win32;
+#define PLATFORM_FILE_WATCHER Win32FileWatcher win32;
 
 struct Win32Window
 {
     HWND window;
 
     int lastCursorPosX, lastCursorPosY;
+};
+
+struct Win32MappedFile
+{
+    HANDLE file;
+    HANDLE mapping;
+};
+
+struct Win32FileWatcher
+{
+    HANDLE directory;
+    HANDLE changeEvent;
+    HANDLE cancelEvent;
+
+    OVERLAPPED overlapped;
+    DWORD buffer[4096];     // FILE_NOTIFY_INFORMATION records, which must be DWORD aligned
 };
\ No newline at end of file